@@ -0,0 +1,329 @@
+#include "AccuracyTest.h"
+
+// original chain (symmetric window), real FFT, exact magnitude: SNR of the spectrum, lowest SNR of a
+// bin, largest error (steps); in brackets the results of the periodic window. One table per FFT size,
+// the spectra of the cases and the rounding noise of the FFT stages differ between the sizes.
+#if NR_OF_FFT_SAMPLES_bit == 9
+const AccuracyTest::Tolerance AccuracyTest::m_tolerances[NR_OF_CASES] = {
+  { 45.0, 23.0, 14.0 },     // toneLow: 48.8, 26.9, 8.5 (48.5, 29.0, 9.5)
+  { 48.0, 45.0, 12.0 },     // tone: 51.6, 49.2, 7.2 (52.3, 48.0, 8.0)
+  { 43.0, 23.0, 14.0 },     // toneHigh: 47.4, 26.3, 7.6 (46.7, 26.3, 9.1)
+  { 14.0, 15.0, 10.0 },     // toneWeak: 17.0, 18.6, 6.4 (19.5, 21.9, 4.4), close to the rounding noise of the FFT
+  { 51.0, 48.0, 16.0 },     // toneFull: 56.5, 55.5, 8.1 (54.0, 51.4, 10.8)
+  { 39.0, 24.0, 7.0 },      // chirp: 42.6, 27.4, 4.8 (42.2, 27.4, 4.8)
+  { 39.0, 22.0, 7.0 },      // noise: 42.1, 25.2, 4.0 (42.7, 25.2, 4.4)
+  { 38.0, 17.0, 13.0 },     // rain: 41.6, 22.3, 8.6 (43.3, 20.4, 5.7)
+  { 0.0, 0.0, 0.0 }         // live: not rated
+};
+#elif NR_OF_FFT_SAMPLES_bit == 11
+const AccuracyTest::Tolerance AccuracyTest::m_tolerances[NR_OF_CASES] = {
+  { 48.0, 44.0, 13.0 },     // toneLow: 51.0, 48.4, 8.1 (51.1, 47.3, 8.6)
+  { 48.0, 44.0, 13.0 },     // tone: 51.0, 48.5, 8.1 (51.1, 47.4, 8.5)
+  { 45.0, 43.0, 15.0 },     // toneHigh: 48.7, 46.6, 9.6 (49.0, 46.6, 7.6)
+  { 12.0, 10.0, 11.0 },     // toneWeak: 15.5, 13.1, 7.1 (17.1, 13.1, 7.1), close to the rounding noise of the FFT
+  { 53.0, 50.0, 14.0 },     // toneFull: 56.1, 54.1, 8.9 (56.3, 53.1, 8.9)
+  { 33.0, 20.0, 8.0 },      // chirp: 36.6, 23.2, 5.2 (36.6, 23.2, 4.9)
+  { 33.0, 20.0, 8.0 },      // noise: 36.6, 23.2, 4.3 (36.5, 23.2, 4.9)
+  { 27.0, 15.0, 12.0 },     // rain: 30.3, 18.2, 8.0 (30.6, 20.3, 7.0)
+  { 0.0, 0.0, 0.0 }         // live: not rated
+};
+#else
+const AccuracyTest::Tolerance AccuracyTest::m_tolerances[NR_OF_CASES] = {
+  { 46.0, 15.0, 13.0 },     // toneLow: 48.8, 18.1, 8.6 (48.9, 18.1, 6.8)
+  { 48.0, 46.0, 11.0 },     // tone: 51.4, 49.1, 7.1 (51.6, 48.0, 8.0)
+  { 46.0, 44.0, 12.0 },     // toneHigh: 49.4, 47.4, 7.9 (50.2, 47.3, 6.9)
+  { 14.0, 10.0, 11.0 },     // toneWeak: 16.9, 13.2, 7.1 (17.7, 14.5, 6.1), close to the rounding noise of the FFT
+  { 53.0, 51.0, 13.0 },     // toneFull: 56.5, 54.2, 8.9 (56.0, 52.2, 9.8)
+  { 36.0, 20.0, 7.0 },      // chirp: 39.5, 23.3, 4.3 (39.6, 23.3, 4.7)
+  { 36.0, 20.0, 7.0 },      // noise: 39.4, 22.7, 4.5 (39.7, 21.7, 5.0)
+  { 34.0, 15.0, 12.0 },     // rain: 37.3, 18.3, 8.2 (37.5, 18.3, 7.2)
+  { 0.0, 0.0, 0.0 }         // live: not rated
+};
+#endif
+
+void AccuracyTest::Begin(SigProc *sigProc, Watchdog *watchdog) {
+  m_sigProc = sigProc;
+  m_watchdog = watchdog;
+}
+
+// params: <case>[,bins]
+// cases: toneLow, tone, toneHigh, toneWeak, toneFull, chirp, noise, rain, live or all (default)
+// "bins" appends the SNR of every bin (';' separated, '-' below ACCURACY_MIN_LEVEL).
+// e.g. "all" or "rain,bins"
+String AccuracyTest::Run(String params) {
+  String caseName = Tools::GetParam(params, 0, "all");
+  bool withBins = Tools::GetParam(params, 1, "") == "bins";
+  bool exact = m_sigProc->m_magMode != Magnitude::MAG_APPROX;
+  float relaxDB = m_sigProc->m_realFFT ? 0 : ACCURACY_RELAX_COMPLEX_DB;
+  float relaxError = m_sigProc->m_realFFT ? 0 : ACCURACY_RELAX_COMPLEX_ERROR;
+  const Tolerance *tolerance;
+  SensorData *sensorData = m_sigProc->m_sensorData;
+  int16_t ADCoffset = sensorData->ADCoffset;
+  uint16_t ADCpeakSample = sensorData->ADCpeakSample;
+  uint16_t clippingCtr = sensorData->clippingCtr;
+  int16_t *samples = new int16_t[NR_OF_FFT_SAMPLES];
+  const int16_t *segment[2];
+  uint32_t segmentLength[2];
+  bool haveLive = false;
+  bool wasCapturing;
+  uint8_t nrOfCases = 0;
+  uint8_t nrOfFailed = 0;
+  String binDetails;
+  String result;
+  Result caseResult;
+  bool passed;
+
+  // the current snapshot of the sensor, taken before the acquisition is stopped
+  m_sigProc->Lock();
+  if (m_sigProc->IsCapturing() && m_sigProc->SnapPending()) {
+    SigProc::m_sampleRb.GetSegments(NR_OF_FFT_SAMPLES, &segment[0], &segmentLength[0], &segment[1], &segmentLength[1]);
+    memcpy(samples, segment[0], segmentLength[0] * sizeof(int16_t));
+    memcpy(samples + segmentLength[0], segment[1], segmentLength[1] * sizeof(int16_t));
+    haveLive = true;
+  }
+  m_sigProc->Unlock();
+
+  wasCapturing = m_sigProc->IsCapturing();
+  m_sigProc->StopCapture();
+
+  for (uint8_t testCase = 0; testCase < NR_OF_CASES; testCase++) {
+    if ((caseName != "all") && (caseName != GetCaseName(testCase))) {
+      continue;
+    }
+    if (testCase == CASE_LIVE) {
+      if (!haveLive) {
+        continue;
+      }
+    } else {
+      FillCase((TestCase)testCase, samples);
+    }
+
+    binDetails = "";
+    caseResult = Compare(samples, withBins ? &binDetails : NULL, exact ? 0 : ACCURACY_APPROX_ERROR);
+    tolerance = &m_tolerances[testCase];
+    passed = (caseResult.snr >= tolerance->minSNR - relaxDB) && (caseResult.minBinSNR >= tolerance->minBinSNR - relaxDB) &&
+      (caseResult.maxError <= tolerance->maxError + relaxError);
+    nrOfCases++;
+    if (!passed && (testCase != CASE_LIVE)) {
+      nrOfFailed++;
+    }
+
+    String name = GetCaseName(testCase);
+    result += name + ".snr=" + String(caseResult.snr, 1) + ",";
+    result += name + ".minBinSNR=" + String(caseResult.minBinSNR, 1) + ",";
+    result += name + ".minBinSNRBin=" + String(caseResult.minBinSNRBin) + ",";
+    result += name + ".maxError=" + String(caseResult.maxError, 2) + ",";
+    result += name + ".maxErrorBin=" + String(caseResult.maxErrorBin) + ",";
+    if (withBins) {
+      result += name + ".bins=" + binDetails + ",";
+    }
+    if (testCase != CASE_LIVE) {
+      result += name + ".result=" + String(passed ? "pass" : "FAIL") + ",";
+    }
+
+    m_watchdog->Handle();
+    yield();
+  }
+
+  delete[] samples;
+  sensorData->ADCoffset = ADCoffset;
+  sensorData->ADCpeakSample = ADCpeakSample;
+  sensorData->clippingCtr = clippingCtr;
+  m_sigProc->ResetCapture();
+  if (wasCapturing) {
+    m_sigProc->StartCapture();
+  }
+
+  if (nrOfCases == 0) {
+    return "accuracy=unknown case";
+  }
+
+  return "accuracy=" + String(nrOfFailed ? "FAIL" : "PASS") + ",failed=" + String(nrOfFailed) + "/" + String(nrOfCases) +
+    ",fft=" + String(m_sigProc->m_realFFT ? "real" : "complex") + ",magnitude=" + String(exact ? "exact" : "approx") + "," + result;
+}
+
+// Synthetic decimated snapshot with an ADC offset of 37 steps
+bool AccuracyTest::FillCase(TestCase testCase, int16_t *samples) {
+  const float sampleRate = SAMPLE_RATE >> 1;
+  SensorData *sensorData = m_sigProc->m_sensorData;
+  float rainFreqMin = sensorData->binGroup[DOM_GROUP_RAIN_FIRST].firstBin * BIN_RESOLUTION;
+  float rainFreqMax = sensorData->binGroup[DOM_GROUP_RAIN_LAST].lastBin * BIN_RESOLUTION;
+  float value;
+
+  m_noiseState = TOOLS_NOISE_SEED;
+
+  for (uint16_t n = 0; n < NR_OF_FFT_SAMPLES; n++) {
+    switch (testCase) {
+    case CASE_TONE_LOW:
+      value = 1000 * sinf(2 * PI * 150.0 * n / sampleRate);
+      break;
+    case CASE_TONE:
+      value = 1000 * sinf(2 * PI * 1000.0 * n / sampleRate);
+      break;
+    case CASE_TONE_HIGH:
+      value = 800 * sinf(2 * PI * 8500.0 * n / sampleRate);
+      break;
+    case CASE_TONE_WEAK:
+      value = 16 * sinf(2 * PI * 700.0 * n / sampleRate);
+      break;
+    case CASE_TONE_FULL:
+      value = 2000 * sinf(2 * PI * 2000.0 * n / sampleRate);
+      break;
+    case CASE_CHIRP:
+      // linear sweep from 20 Hz to 9 kHz within the snapshot
+      value = 800 * sinf(2 * PI * (20.0 + (9000.0 - 20.0) * n / (2.0 * NR_OF_FFT_SAMPLES)) * n / sampleRate);
+      break;
+    case CASE_NOISE:
+      value = Tools::NextNoise(m_noiseState, 1000);
+      break;
+    default:
+      value = Tools::NextNoise(m_noiseState, 20);
+      break;
+    }
+    samples[n] = 37 + lroundf(value);
+  }
+
+  if (testCase == CASE_RAIN) {
+    // drops: decaying bursts at random doppler frequencies of the rain bin groups on a noise floor
+    for (uint8_t drop = 0; drop < 12; drop++) {
+      uint16_t start = (uint16_t)(Tools::NextNoise(m_noiseState, 32767) + 32768) % NR_OF_FFT_SAMPLES;
+      float freq = rainFreqMin + (rainFreqMax - rainFreqMin) * (Tools::NextNoise(m_noiseState, 32767) + 32768) / 65536.0;
+      float amplitude = 100 + 700.0 * (Tools::NextNoise(m_noiseState, 32767) + 32768) / 65536.0;
+      float decay = 40 + 160.0 * (Tools::NextNoise(m_noiseState, 32767) + 32768) / 65536.0;
+
+      for (uint16_t n = start; n < NR_OF_FFT_SAMPLES; n++) {
+        value = samples[n] + amplitude * expf(-(n - start) / decay) * sinf(2 * PI * freq * (n - start) / sampleRate);
+        samples[n] = constrain(lroundf(value), -2048, 2047);
+      }
+    }
+  }
+
+  return true;
+}
+
+AccuracyTest::Result AccuracyTest::Compare(const int16_t *samples, String *binDetails, float approxError) {
+  int16_t *re = new int16_t[NR_OF_FFT_SAMPLES];
+  int16_t *im = new int16_t[NR_OF_FFT_SAMPLES];
+  double *refRe = new double[NR_OF_FFT_SAMPLES];
+  double *refIm = new double[NR_OF_FFT_SAMPLES];
+  double refPower = 0;
+  double errorPower = 0;
+  double reference;
+  double error;
+  double binSNR;
+  Result result;
+
+  // the fixed point chain reads the snapshot from the ringbuffer, like SigProc::Calc()
+  SigProc::m_sampleRb.Reset();
+  SigProc::m_sampleRb.Write(samples, NR_OF_FFT_SAMPLES);
+  m_sigProc->Preprocess(re, im);
+  m_sigProc->CalcSpectrum(re, im);
+  SigProc::m_sampleRb.Reset();
+
+  ReferenceMagnitudes(samples, refRe, refIm);
+
+  result.minBinSNR = 200;
+  result.minBinSNRBin = 0;
+  result.maxError = 0;
+  result.maxErrorBin = 0;
+
+  for (uint16_t binNr = ACCURACY_FIRST_BIN; binNr < NR_OF_BINS; binNr++) {
+    reference = refRe[binNr];
+    error = m_sigProc->m_sensorData->bin.mag[binNr] - reference;
+    // the approximated magnitude is rated by its deviation beyond the error of the approximation, which
+    // grows with the magnitude and would otherwise depend on the peak levels of a case (FFT size)
+    error = error > 0 ? max(error - approxError * reference, 0.0) : min(error + approxError * reference, 0.0);
+    refPower += reference * reference;
+    errorPower += error * error;
+
+    if (fabs(error) > result.maxError) {
+      result.maxError = fabs(error);
+      result.maxErrorBin = binNr;
+    }
+
+    // an error below half a step is rounding, not a loss of accuracy
+    binSNR = reference >= ACCURACY_MIN_LEVEL ? 20 * log10(reference / max(fabs(error), 0.5)) : 200;
+    if (binSNR < result.minBinSNR) {
+      result.minBinSNR = binSNR;
+      result.minBinSNRBin = binNr;
+    }
+    if (binDetails) {
+      *binDetails += (binNr > ACCURACY_FIRST_BIN ? ";" : "") + (reference >= ACCURACY_MIN_LEVEL ? String(binSNR, 1) : String("-"));
+    }
+  }
+
+  result.snr = errorPower > 0 ? 10 * log10(refPower / errorPower) : 200;
+
+  delete[] re;
+  delete[] im;
+  delete[] refRe;
+  delete[] refIm;
+  return result;
+}
+
+// Double precision magnitudes of the snapshot, processed like the original fixed point chain (mean
+// removed in the time domain, input << 4, symmetric Hann window, 1/N), written to re[0 ... NR_OF_BINS - 1]
+void AccuracyTest::ReferenceMagnitudes(const int16_t *samples, double *re, double *im) {
+  const uint16_t N = NR_OF_FFT_SAMPLES;
+  double mean = 0;
+  double wRe, wIm, stepRe, stepIm, tRe, tIm, tmp;
+  uint16_t j = 0;
+  uint16_t bit;
+
+  for (uint16_t n = 0; n < N; n++) {
+    mean += samples[n];
+  }
+  mean /= N;
+
+  // windowed input in bit reversed order
+  for (uint16_t n = 0; n < N; n++) {
+    re[j] = (samples[n] - mean) * 16.0 * 0.5 * (1.0 - cos(2.0 * PI * n / (N - 1)));
+    im[j] = 0;
+    for (bit = N >> 1; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j |= bit;
+  }
+
+  // radix-2 decimation in time
+  for (uint16_t len = 2; len <= N; len <<= 1) {
+    stepRe = cos(-2.0 * PI / len);
+    stepIm = sin(-2.0 * PI / len);
+    for (uint16_t i = 0; i < N; i += len) {
+      wRe = 1;
+      wIm = 0;
+      for (uint16_t k = 0; k < (len >> 1); k++) {
+        uint16_t a = i + k;
+        uint16_t b = a + (len >> 1);
+        tRe = re[b] * wRe - im[b] * wIm;
+        tIm = re[b] * wIm + im[b] * wRe;
+        re[b] = re[a] - tRe;
+        im[b] = im[a] - tIm;
+        re[a] += tRe;
+        im[a] += tIm;
+        tmp = wRe * stepRe - wIm * stepIm;
+        wIm = wRe * stepIm + wIm * stepRe;
+        wRe = tmp;
+      }
+    }
+  }
+
+  for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+    re[binNr] = sqrt(re[binNr] * re[binNr] + im[binNr] * im[binNr]) / N;
+  }
+}
+
+String AccuracyTest::GetCaseName(uint8_t testCase) {
+  switch (testCase) {
+    case CASE_TONE_LOW: return "toneLow";
+    case CASE_TONE: return "tone";
+    case CASE_TONE_HIGH: return "toneHigh";
+    case CASE_TONE_WEAK: return "toneWeak";
+    case CASE_TONE_FULL: return "toneFull";
+    case CASE_CHIRP: return "chirp";
+    case CASE_NOISE: return "noise";
+    case CASE_RAIN: return "rain";
+    case CASE_LIVE: return "live";
+    default: return "?";
+  }
+}
@@ -0,0 +1,72 @@
+#ifndef __ACCURACYTEST__h
+#define __ACCURACYTEST__h
+
+#include "Arduino.h"
+#include "GlobalDefines.h"
+#include "SigProc.h"
+#include "Watchdog.h"
+#include "Tools.h"
+
+#define ACCURACY_FIRST_BIN           2          // bins 0 and 1 carry the remainder of the integer ADC offset
+#define ACCURACY_MIN_LEVEL           32.0       // bins below are not rated by their own SNR (quantization floor)
+#define ACCURACY_RELAX_COMPLEX_DB    7.0        // tolerances of the complex FFT relative to the real FFT
+#define ACCURACY_RELAX_COMPLEX_ERROR 6.0
+#define ACCURACY_APPROX_ERROR        0.03       // error of Magnitude::Approx() (-2.8 % ... +0.7 %), not rated
+
+// Regression test of the fixed point spectrum against a double precision reference.
+// The configured chain (SigProc::Preprocess -> FFT -> RemoveDC -> magnitude) and a double precision
+// model of the original chain (mean removed in the time domain, symmetric Hann window, same
+// scaling) are compared bin by bin. The tolerances per case and FFT size are the results of the
+// original chain ("Window" = "symmetric", real FFT, exact magnitude) with a margin of 3 dB / 50 %, so a
+// change that shifts the magnitudes, and with them the stored magThresh calibrations, makes the test
+// fail. The approximated magnitude is rated by its deviation beyond its own error.
+// The periodic window (opt-in) is expected to deviate by up to 1 dB and 1 step from these results at
+// 1024 and 2048 points, by up to 3 dB and 3 steps at 512 points (see m_tolerances), its DC removal in
+// the spectrum only affects bins 0 and 1, which are not rated.
+// The live snapshot is reported only.
+class AccuracyTest {
+public:
+  enum TestCase {
+    CASE_TONE_LOW,
+    CASE_TONE,
+    CASE_TONE_HIGH,
+    CASE_TONE_WEAK,
+    CASE_TONE_FULL,
+    CASE_CHIRP,
+    CASE_NOISE,
+    CASE_RAIN,
+    CASE_LIVE,            // the current snapshot of the sensor
+    NR_OF_CASES
+  };
+
+  void Begin(SigProc *sigProc, Watchdog *watchdog);
+  String Run(String params);
+
+private:
+  struct Tolerance {
+    float minSNR;
+    float minBinSNR;
+    float maxError;
+  };
+
+  struct Result {
+    float snr;
+    float minBinSNR;
+    uint16_t minBinSNRBin;
+    float maxError;
+    uint16_t maxErrorBin;
+  };
+
+  static const Tolerance m_tolerances[NR_OF_CASES];
+
+  SigProc *m_sigProc;
+  Watchdog *m_watchdog;
+  uint32_t m_noiseState;
+
+  bool FillCase(TestCase testCase, int16_t *samples);
+  Result Compare(const int16_t *samples, String *binDetails, float approxError);
+  void ReferenceMagnitudes(const int16_t *samples, double *re, double *im);
+  static String GetCaseName(uint8_t testCase);
+};
+
+#endif
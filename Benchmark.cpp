@@ -0,0 +1,691 @@
+#include "Benchmark.h"
+
+void Benchmark::Begin(SigProc *sigProc, Watchdog *watchdog) {
+  m_sigProc = sigProc;
+  m_watchdog = watchdog;
+}
+
+// params: <kernel>,<iterations>
+// kernels: fft, mag, prep, win, fir, sdft, hum, zoom, stat or all, e.g. "fft,100"
+String Benchmark::Run(String params) {
+  String kernel = Tools::GetParam(params, 0, "all");
+  uint16_t iterations = Tools::GetParam(params, 1, "100").toInt();
+  String result = "benchmark=cpuMHz=" + String(ESP.getCpuFreqMHz()) + ",";
+  bool wasCapturing;
+
+  if (iterations < 1) {
+    iterations = 1;
+  }
+
+  // the sampling ISR would falsify the cycle counts
+  wasCapturing = m_sigProc->IsCapturing();
+  m_sigProc->StopCapture();
+
+  if (kernel == "fft" || kernel == "all") {
+    result += RunFFT(iterations);
+  }
+  if (kernel == "mag" || kernel == "all") {
+    result += RunMagnitude(iterations);
+  }
+  if (kernel == "prep" || kernel == "all") {
+    result += RunPreprocess(iterations);
+  }
+  if (kernel == "win" || kernel == "all") {
+    result += RunWindow(iterations);
+  }
+  if (kernel == "fir" || kernel == "all") {
+    result += RunDecimator(iterations);
+  }
+  if (kernel == "sdft" || kernel == "all") {
+    result += RunSlidingDFT(iterations);
+  }
+  if (kernel == "hum" || kernel == "all") {
+    result += RunHumCanceller(iterations);
+  }
+  if (kernel == "zoom" || kernel == "all") {
+    result += RunZoom(iterations);
+  }
+  if (kernel == "stat" || kernel == "all") {
+    result += RunStatistics(iterations);
+  }
+
+  if (wasCapturing) {
+    m_sigProc->ResetCapture();
+    m_sigProc->StartCapture();
+  }
+
+  return result;
+}
+
+String Benchmark::RunFFT(uint16_t iterations) {
+  int16_t re[NR_OF_FFT_SAMPLES];
+  int16_t im[NR_OF_FFT_SAMPLES];
+  uint16_t magRef[NR_OF_BINS];
+  uint16_t magRadix4[NR_OF_BINS];
+  uint16_t magReal[NR_OF_BINS];
+  uint64_t cyclesRadix2 = 0;
+  uint64_t cyclesRadix4 = 0;
+  uint64_t cyclesReal = 0;
+  uint32_t startCycles;
+  String result;
+
+  for (uint16_t i = 0; i < iterations; i++) {
+    // radix-2 complex FFT with zero imaginary part (reference)
+    FillTestSignal(re, im, NR_OF_FFT_SAMPLES);
+    startCycles = ESP.getCycleCount();
+    m_sigProc->m_fft.FFTRadix2(re, im);
+    cyclesRadix2 += ESP.getCycleCount() - startCycles;
+    CalcMagnitudes(re, im, magRef, NR_OF_BINS);
+
+    // radix-4 complex FFT with bit reversal table
+    FillTestSignal(re, im, NR_OF_FFT_SAMPLES);
+    startCycles = ESP.getCycleCount();
+    m_sigProc->m_fft.FFT(re, im);
+    cyclesRadix4 += ESP.getCycleCount() - startCycles;
+    CalcMagnitudes(re, im, magRadix4, NR_OF_BINS);
+
+    // real input FFT
+    FillTestSignal(re, im, NR_OF_FFT_SAMPLES);
+    startCycles = ESP.getCycleCount();
+    m_sigProc->m_fft.RealFFT(re, im);
+    cyclesReal += ESP.getCycleCount() - startCycles;
+    CalcMagnitudes(re, im, magReal, NR_OF_BINS);
+
+    m_watchdog->Handle();
+  }
+
+  result += FormatCycles("fft.radix2", cyclesRadix2, iterations, NR_OF_FFT_SAMPLES);
+  result += FormatCycles("fft.radix4", cyclesRadix4, iterations, NR_OF_FFT_SAMPLES);
+  result += FormatCycles("fft.real", cyclesReal, iterations, NR_OF_FFT_SAMPLES);
+  result += "fft.radix4.speedup=" + String(cyclesRadix4 ? (float)cyclesRadix2 / cyclesRadix4 : 0, 2) + ",";
+  result += "fft.real.speedup=" + String(cyclesReal ? (float)cyclesRadix2 / cyclesReal : 0, 2) + ",";
+  result += CompareMagnitudes("fft.radix4", magRadix4, magRef, NR_OF_BINS);
+  result += CompareMagnitudes("fft.real", magReal, magRef, NR_OF_BINS);
+
+  return result;
+}
+
+String Benchmark::RunMagnitude(uint16_t iterations) {
+  int16_t re[NR_OF_FFT_SAMPLES];
+  int16_t im[NR_OF_FFT_SAMPLES];
+  uint16_t mag[NR_OF_BINS];
+  uint32_t power[NR_OF_BINS];
+  uint64_t cyclesDouble = 0;
+  uint64_t cyclesExact = 0;
+  uint64_t cyclesApprox = 0;
+  uint64_t cyclesPower = 0;
+  uint32_t startCycles;
+  uint16_t exactMismatches = 0;
+  float approxMinErr = 0;
+  float approxMaxErr = 0;
+  uint16_t approxMaxAbsErr = 0;
+  String result;
+
+  FillTestSignal(re, im, NR_OF_FFT_SAMPLES);
+  m_sigProc->m_fft.RealFFT(re, im);
+
+  for (uint16_t i = 0; i < iterations; i++) {
+    // former implementation
+    startCycles = ESP.getCycleCount();
+    for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+      mag[binNr] = sqrt(pow(re[binNr], 2) + pow(im[binNr], 2));
+    }
+    cyclesDouble += ESP.getCycleCount() - startCycles;
+    Consume(mag, NR_OF_BINS);
+
+    startCycles = ESP.getCycleCount();
+    for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+      mag[binNr] = Magnitude::Exact(re[binNr], im[binNr]);
+    }
+    cyclesExact += ESP.getCycleCount() - startCycles;
+    Consume(mag, NR_OF_BINS);
+
+    startCycles = ESP.getCycleCount();
+    for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+      mag[binNr] = Magnitude::Approx(re[binNr], im[binNr]);
+    }
+    cyclesApprox += ESP.getCycleCount() - startCycles;
+    Consume(mag, NR_OF_BINS);
+
+    startCycles = ESP.getCycleCount();
+    for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+      power[binNr] = Magnitude::Power(re[binNr], im[binNr]);
+    }
+    cyclesPower += ESP.getCycleCount() - startCycles;
+    Consume(power, NR_OF_BINS);
+
+    m_watchdog->Handle();
+  }
+
+  // error report against the double precision result, over the test spectrum and a sweep of angles
+  for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+    uint16_t reference = sqrt(pow(re[binNr], 2) + pow(im[binNr], 2));
+    if (Magnitude::Exact(re[binNr], im[binNr]) != reference) {
+      exactMismatches++;
+    }
+    uint16_t absErr = abs((int32_t)Magnitude::Approx(re[binNr], im[binNr]) - reference);
+    if (absErr > approxMaxAbsErr) {
+      approxMaxAbsErr = absErr;
+    }
+  }
+  for (uint16_t angle = 0; angle < 360; angle++) {
+    int16_t testRe = 16384 * cos(angle * PI / 180);
+    int16_t testIm = 16384 * sin(angle * PI / 180);
+    float reference = sqrt(pow(testRe, 2) + pow(testIm, 2));
+    float err = 100.0 * (Magnitude::Approx(testRe, testIm) - reference) / reference;
+    if (err < approxMinErr) {
+      approxMinErr = err;
+    }
+    if (err > approxMaxErr) {
+      approxMaxErr = err;
+    }
+    if (Magnitude::Exact(testRe, testIm) != (uint16_t)reference) {
+      exactMismatches++;
+    }
+  }
+
+  result += FormatCycles("mag.double", cyclesDouble, iterations, NR_OF_BINS);
+  result += FormatCycles("mag.exact", cyclesExact, iterations, NR_OF_BINS);
+  result += FormatCycles("mag.approx", cyclesApprox, iterations, NR_OF_BINS);
+  result += FormatCycles("mag.power", cyclesPower, iterations, NR_OF_BINS);
+  result += "mag.exact.mismatches=" + String(exactMismatches) + ",";
+  result += "mag.approx.maxAbsErr=" + String(approxMaxAbsErr) + ",";
+  result += "mag.approx.minRelErr=" + String(approxMinErr, 2) + ",";
+  result += "mag.approx.maxRelErr=" + String(approxMaxErr, 2) + ",";
+
+  return result;
+}
+
+// Snapshot preprocessing: former three passes over the ringbuffer (offset, clipping/peak/scaling, window)
+// against the fused single pass. The test snapshot wraps around the end of the ringbuffer.
+String Benchmark::RunPreprocess(uint16_t iterations) {
+  int16_t re[NR_OF_FFT_SAMPLES];
+  int16_t im[NR_OF_FFT_SAMPLES];
+  uint16_t magRef[NR_OF_BINS];
+  uint16_t magFused[NR_OF_BINS];
+  uint64_t cyclesThreePass = 0;
+  uint64_t cyclesFused = 0;
+  uint32_t startCycles;
+  SensorData *sensorData = m_sigProc->m_sensorData;
+  int16_t ADCoffset = sensorData->ADCoffset;
+  uint16_t ADCpeakSample = sensorData->ADCpeakSample;
+  uint16_t clippingCtr = sensorData->clippingCtr;
+  int16_t zeros[NR_OF_FFT_SAMPLES >> 1];
+  int16_t sample;
+  int32_t sampleSUM;
+  uint16_t sampleABS;
+  String result;
+
+  // move the read position to RINGBUFFER_SIZE - NR_OF_FFT_SAMPLES / 2
+  memset(zeros, 0, sizeof(zeros));
+  SigProc::m_sampleRb.Reset();
+  for (uint16_t n = 0; n < (RINGBUFFER_SIZE / (NR_OF_FFT_SAMPLES >> 1)) - 1; n++) {
+    SigProc::m_sampleRb.Write(zeros, NR_OF_FFT_SAMPLES >> 1);
+    SigProc::m_sampleRb.Consume(NR_OF_FFT_SAMPLES >> 1);
+  }
+
+  // same test signal as FillTestSignal(), unscaled and with an ADC offset
+  m_noiseState = TOOLS_NOISE_SEED;
+  for (uint16_t n = 0; n < NR_OF_FFT_SAMPLES; n++) {
+    re[n] = NextTestSample(n, SAMPLE_RATE >> 1) + 37;
+  }
+  SigProc::m_sampleRb.Write(re, NR_OF_FFT_SAMPLES);
+
+  for (uint16_t i = 0; i < iterations; i++) {
+    // former implementation, indexed access to every sample
+    startCycles = ESP.getCycleCount();
+    sampleSUM = 0;
+    for (uint16_t n = 0; n < NR_OF_FFT_SAMPLES; n++) {
+      sampleSUM += SigProc::m_sampleRb.Peek(n);
+    }
+    sensorData->ADCoffset = sampleSUM >> NR_OF_FFT_SAMPLES_bit;
+    for (uint16_t n = 0; n < NR_OF_FFT_SAMPLES; n++) {
+      sample = SigProc::m_sampleRb.Peek(n);
+      if ((sample < -2047) || (sample > 2046)) {
+        sensorData->clippingCtr++;
+      }
+      sampleABS = abs(sample);
+      if (sampleABS > sensorData->ADCpeakSample) {
+        sensorData->ADCpeakSample = sampleABS;
+      }
+      sample -= sensorData->ADCoffset;
+      re[n] = sample << 4;
+    }
+    m_sigProc->m_fft.Window(re);
+    cyclesThreePass += ESP.getCycleCount() - startCycles;
+    m_sigProc->m_fft.RealFFT(re, im);
+    CalcMagnitudes(re, im, magRef, NR_OF_BINS);
+
+    startCycles = ESP.getCycleCount();
+    m_sigProc->Preprocess(re, im);
+    cyclesFused += ESP.getCycleCount() - startCycles;
+    if (m_sigProc->m_realFFT) {
+      m_sigProc->m_fft.RealFFTPacked(re, im);
+    } else {
+      m_sigProc->m_fft.FFT(re, im);
+    }
+    if (m_sigProc->m_fft.GetWindowType() == FFTEngine<NR_OF_FFT_SAMPLES_bit>::WINDOW_PERIODIC) {
+      m_sigProc->m_fft.RemoveDC(re, sensorData->ADCoffset << 4);
+    }
+    CalcMagnitudes(re, im, magFused, NR_OF_BINS);
+
+    m_watchdog->Handle();
+  }
+
+  sensorData->ADCoffset = ADCoffset;
+  sensorData->ADCpeakSample = ADCpeakSample;
+  sensorData->clippingCtr = clippingCtr;
+  SigProc::m_sampleRb.Reset();
+
+  result += FormatCycles("prep.threePass", cyclesThreePass, iterations, NR_OF_FFT_SAMPLES);
+  result += FormatCycles("prep.fused", cyclesFused, iterations, NR_OF_FFT_SAMPLES);
+  result += "prep.fused.speedup=" + String(cyclesFused ? (float)cyclesThreePass / cyclesFused : 0, 2) + ",";
+  result += CompareMagnitudes("prep.fused", magFused, magRef, NR_OF_BINS);
+
+  return result;
+}
+
+// 2x FIR decimation: former per-sample filter with a wrapping history (as it ran in the ISR)
+// against the block decimator. Both must produce identical samples.
+String Benchmark::RunDecimator(uint16_t iterations) {
+  const uint16_t nrOfRawSamples = NR_OF_FFT_SAMPLES;
+  uint16_t raw[NR_OF_FFT_SAMPLES];
+  int16_t outRef[NR_OF_FFT_SAMPLES >> 1];
+  int16_t outBlock[(NR_OF_FFT_SAMPLES >> 1) + 1];
+  int16_t firRb[FILTER_TAP_NUM];
+  uint8_t firRbPtr;
+  int32_t FIRsum;
+  uint16_t outRefCnt = 0;
+  uint16_t outBlockCnt = 0;
+  uint16_t mismatches = 0;
+  uint64_t cyclesPerSample = 0;
+  uint64_t cyclesBlock = 0;
+  uint32_t startCycles;
+  Decimator decimator;
+  String result;
+
+  m_noiseState = TOOLS_NOISE_SEED;
+  for (uint16_t n = 0; n < nrOfRawSamples; n++) {
+    raw[n] = 2048 + NextTestSample(n, SAMPLE_RATE);
+  }
+
+  for (uint16_t i = 0; i < iterations; i++) {
+    // former implementation
+    memset(firRb, 0, sizeof(firRb));
+    firRbPtr = 0;
+    outRefCnt = 0;
+    startCycles = ESP.getCycleCount();
+    for (uint16_t n = 0; n < nrOfRawSamples; n++) {
+      firRb[firRbPtr] = raw[n] - 2048;
+      if (firRbPtr & 0x01) {
+        FIRsum = 0;
+        for (uint16_t k = 0; k < FILTER_TAP_NUM_HALF; k++) {
+          FIRsum += Decimator::FIRcoeff[k] * (firRb[(firRbPtr - k) & (FILTER_TAP_NUM - 1)] + firRb[(firRbPtr - (FILTER_TAP_NUM - 1) + k) & (FILTER_TAP_NUM - 1)]);
+        }
+        outRef[outRefCnt++] = FIRsum >> 15;
+      }
+      firRbPtr = (firRbPtr + 1) & (FILTER_TAP_NUM - 1);
+    }
+    cyclesPerSample += ESP.getCycleCount() - startCycles;
+
+    decimator.Reset();
+    startCycles = ESP.getCycleCount();
+    outBlockCnt = decimator.Process(raw, nrOfRawSamples, outBlock);
+    cyclesBlock += ESP.getCycleCount() - startCycles;
+
+    m_watchdog->Handle();
+  }
+
+  for (uint16_t n = 0; n < outRefCnt; n++) {
+    if ((n >= outBlockCnt) || (outBlock[n] != outRef[n])) {
+      mismatches++;
+    }
+  }
+
+  result += FormatCycles("fir.perSample", cyclesPerSample, iterations, nrOfRawSamples);
+  result += FormatCycles("fir.block", cyclesBlock, iterations, nrOfRawSamples);
+  result += "fir.block.speedup=" + String(cyclesBlock ? (float)cyclesPerSample / cyclesBlock : 0, 2) + ",";
+  result += "fir.block.mismatches=" + String(mismatches) + ",";
+
+  return result;
+}
+
+// Sliding DFT over the rain bin groups, fed with the samples of one snapshot, against the radix-4 FFT
+// of the same snapshot. cyclesPerSample compares to the FFT cycles divided by the snapshot hop.
+String Benchmark::RunSlidingDFT(uint16_t iterations) {
+  int16_t re[NR_OF_FFT_SAMPLES];
+  int16_t im[NR_OF_FFT_SAMPLES];
+  uint16_t magRef[NR_OF_BINS];
+  uint16_t magSDFT[NR_OF_BINS];
+  uint16_t firstBin, lastBin;
+  uint64_t cycles = 0;
+  uint32_t startCycles;
+  SlidingDFT sdft;
+  String result;
+
+  FillTestSignal(re, im, NR_OF_FFT_SAMPLES);
+  m_sigProc->m_fft.FFT(re, im);
+  CalcMagnitudes(re, im, magRef, NR_OF_BINS);
+
+  sdft.Begin(m_sigProc->m_sensorData->binGroup[DOM_GROUP_RAIN_FIRST].firstBin, m_sigProc->m_sensorData->binGroup[DOM_GROUP_RAIN_LAST].lastBin);
+  firstBin = sdft.GetFirstBin();
+  lastBin = sdft.GetLastBin();
+
+  // same test signal as FillTestSignal(), unscaled and without window
+  m_noiseState = TOOLS_NOISE_SEED;
+  for (uint16_t n = 0; n < NR_OF_FFT_SAMPLES; n++) {
+    re[n] = NextTestSample(n, SAMPLE_RATE >> 1);
+  }
+
+  for (uint16_t i = 0; i < iterations; i++) {
+    sdft.Reset();
+    startCycles = ESP.getCycleCount();
+    sdft.Update(re, NR_OF_FFT_SAMPLES);
+    cycles += ESP.getCycleCount() - startCycles;
+
+    m_watchdog->Handle();
+  }
+
+  for (uint16_t binNr = firstBin; binNr <= lastBin; binNr++) {
+    magSDFT[binNr] = sdft.Magnitude(binNr);
+  }
+
+  result += FormatCycles("sdft", cycles, iterations, NR_OF_FFT_SAMPLES);
+  result += "sdft.bins=" + String(lastBin - firstBin + 1) + ",";
+  result += CompareMagnitudes("sdft", &magSDFT[firstBin], &magRef[firstBin], lastBin - firstBin + 1);
+
+  return result;
+}
+
+// Hum canceller (50 Hz) on the test signal plus 50 Hz hum with harmonics, continued over the
+// iterations. The cycles per sample are compared to the cycles available per decimated sample, the
+// suppression is the hum power against the remaining deviation from the hum free signal.
+String Benchmark::RunHumCanceller(uint16_t iterations) {
+  int16_t clean[NR_OF_FFT_SAMPLES];
+  int16_t samples[NR_OF_FFT_SAMPLES];
+  uint64_t cycles = 0;
+  uint32_t startCycles;
+  uint32_t sampleNr = 0;
+  float budget = (float)ESP.getCpuFreqMHz() * 1000000 / (SAMPLE_RATE >> 1);
+  float cyclesPerSample;
+  float humPower = 0;
+  float residualPower = 0;
+  int16_t hum;
+  HumCanceller humCanceller;
+  String result;
+
+  humCanceller.Begin(50);
+  m_noiseState = TOOLS_NOISE_SEED;
+  for (uint16_t i = 0; i < iterations; i++) {
+    // same test signal as FillTestSignal(), unscaled, hum: 300 at 50 Hz, 100 at 150 Hz
+    for (uint16_t n = 0; n < NR_OF_FFT_SAMPLES; n++, sampleNr++) {
+      clean[n] = NextTestSample(sampleNr, SAMPLE_RATE >> 1);
+      hum = 300 * sinf(2 * PI * 50.0 * sampleNr / (SAMPLE_RATE >> 1)) + 100 * sinf(2 * PI * 150.0 * sampleNr / (SAMPLE_RATE >> 1));
+      samples[n] = clean[n] + hum;
+      if (i >= (iterations >> 1)) {
+        humPower += hum * hum;
+      }
+    }
+
+    startCycles = ESP.getCycleCount();
+    humCanceller.Process(samples, NR_OF_FFT_SAMPLES);
+    cycles += ESP.getCycleCount() - startCycles;
+
+    // second half only, after the weights have converged
+    if (i >= (iterations >> 1)) {
+      for (uint16_t n = 0; n < NR_OF_FFT_SAMPLES; n++) {
+        residualPower += (samples[n] - clean[n]) * (samples[n] - clean[n]);
+      }
+    }
+
+    m_watchdog->Handle();
+  }
+
+  cyclesPerSample = (float)cycles / iterations / NR_OF_FFT_SAMPLES;
+  result += FormatCycles("hum", cycles, iterations, NR_OF_FFT_SAMPLES);
+  result += "hum.budgetCyclesPerSample=" + String(budget, 0) + ",";
+  result += "hum.budgetShare=" + String(100 * cyclesPerSample / budget, 1) + ",";
+  result += "hum.suppression=" + String(residualPower > 0 ? 10 * log10f(humPower / residualPower) : 0, 1) + ",";
+  result += "hum.amplitude=" + String(humCanceller.GetAmplitude()) + ",";
+
+  return result;
+}
+
+// Hann window of a snapshot on its own (fused into the preprocessing pass in SigProc)
+String Benchmark::RunWindow(uint16_t iterations) {
+  int16_t re[NR_OF_FFT_SAMPLES];
+  int16_t im[NR_OF_FFT_SAMPLES];
+  uint64_t cycles = 0;
+  uint32_t startCycles;
+
+  for (uint16_t i = 0; i < iterations; i++) {
+    FillTestSignal(re, im, NR_OF_FFT_SAMPLES);
+    startCycles = ESP.getCycleCount();
+    m_sigProc->m_fft.Window(re);
+    cycles += ESP.getCycleCount() - startCycles;
+    Consume((uint16_t *)re, NR_OF_FFT_SAMPLES);
+
+    m_watchdog->Handle();
+  }
+
+  return FormatCycles("win.window", cycles, iterations, NR_OF_FFT_SAMPLES);
+}
+
+// Zoom FFT for both zoom factors: decimation filter per input sample and FFT + magnitudes per
+// zoom snapshot. The input is the unwindowed test signal at the decimated sample rate.
+String Benchmark::RunZoom(uint16_t iterations) {
+  const uint8_t factors[] = { 4, 8 };
+  int16_t re[NR_OF_FFT_SAMPLES];
+  int16_t im[NR_OF_FFT_SAMPLES];
+  uint64_t cyclesFIR;
+  uint64_t cyclesFFT;
+  uint32_t startCycles;
+  uint32_t snapshots;
+  uint32_t sampleNr;
+  ZoomFFT *zoom = new ZoomFFT();
+  String name;
+  String result;
+
+  for (uint8_t f = 0; f < sizeof(factors); f++) {
+    zoom->Begin(factors[f], &m_sigProc->m_fft);
+    cyclesFIR = 0;
+    cyclesFFT = 0;
+    snapshots = 0;
+    sampleNr = 0;
+    m_noiseState = TOOLS_NOISE_SEED;
+
+    for (uint16_t i = 0; i < iterations; i++) {
+      for (uint16_t n = 0; n < NR_OF_FFT_SAMPLES; n++, sampleNr++) {
+        re[n] = NextTestSample(sampleNr, SAMPLE_RATE >> 1, 500.0);
+      }
+
+      startCycles = ESP.getCycleCount();
+      zoom->AddSamples(re, NR_OF_FFT_SAMPLES);
+      cyclesFIR += ESP.getCycleCount() - startCycles;
+
+      if (zoom->SnapPending()) {
+        startCycles = ESP.getCycleCount();
+        zoom->Calc(re, im);
+        for (uint16_t binNr = 0; binNr < NR_OF_ZOOM_BINS; binNr++) {
+          re[binNr] = Magnitude::Exact(re[binNr], im[binNr]);
+        }
+        cyclesFFT += ESP.getCycleCount() - startCycles;
+        Consume((uint16_t *)re, NR_OF_ZOOM_BINS);
+        snapshots++;
+      }
+
+      m_watchdog->Handle();
+    }
+
+    name = "zoom" + String(factors[f]);
+    result += FormatCycles(name + ".fir", cyclesFIR, iterations, NR_OF_FFT_SAMPLES);
+    if (snapshots > 0) {
+      result += FormatCycles(name + ".fft", cyclesFFT, snapshots, NR_OF_ZOOM_BINS);
+    }
+  }
+
+  delete zoom;
+  return result;
+}
+
+// Statistics of a snapshot (Calc), of a gated snapshot (AddQuietSnapshot) and of an interval
+// (Finalize after 64 snapshots), on a copy of the sensor data with the bins of the test spectrum.
+// The snapshot statistics are compared to the former interleaved bin layout (one struct per bin)
+// with float accumulation.
+String Benchmark::RunStatistics(uint16_t iterations) {
+  struct InterleavedBin {
+    uint16_t mag;
+    uint16_t magMax;
+    float magSum;
+    float magAVG;
+    float magAVGkorr;
+  };
+  const uint8_t snapshotsPerInterval = 64;
+  int16_t re[NR_OF_FFT_SAMPLES];
+  int16_t im[NR_OF_FFT_SAMPLES];
+  InterleavedBin *interleaved = new InterleavedBin[NR_OF_BINS]();
+  float *dropInFOVsnapshots = new float[NR_OF_BINS];
+  float thresholdOffset = m_sigProc->m_settings->GetFloat("ThresholdOffset", DEFAULT_THRESHOLD_OFFSET);
+  float weight = 1.0;
+  uint16_t hop = NR_OF_FFT_SAMPLES >> 1;
+  uint64_t cyclesInterleaved = 0;
+  uint64_t cyclesCalc = 0;
+  uint64_t cyclesQuiet = 0;
+  uint64_t cyclesFinalize = 0;
+  uint32_t startCycles;
+  SensorData *sensorData = new SensorData(NR_OF_BINS, NR_OF_BIN_GROUPS);
+  Statistics *statistics = new Statistics();
+  String result;
+
+  sensorData->CopyFrom(m_sigProc->m_sensorData);
+  statistics->Begin(m_sigProc->m_settings, sensorData);
+
+  FillTestSignal(re, im, NR_OF_FFT_SAMPLES);
+  m_sigProc->m_fft.FFT(re, im);
+
+  dropInFOVsnapshots[0] = 1.0;
+  for (uint16_t binNr = 1; binNr < NR_OF_BINS; binNr++) {
+    dropInFOVsnapshots[binNr] = DROP_IN_FOV_TIME_FREQ / (binNr * BIN_RESOLUTION * ((float)(NR_OF_FFT_SAMPLES >> 1) / (SAMPLE_RATE >> 1)));
+  }
+
+  for (uint16_t i = 0; i < iterations; i++) {
+    for (uint8_t s = 0; s < snapshotsPerInterval; s++) {
+      // varies the spectrum a little, so the thresholds are crossed by some bins only
+      for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+        sensorData->bin.mag[binNr] = Magnitude::Exact(re[binNr], im[binNr]) + ((binNr + s) & 0x07);
+        interleaved[binNr].mag = sensorData->bin.mag[binNr];
+      }
+
+      // former layout and float accumulation, same loops as Statistics::Calc() before
+      startCycles = ESP.getCycleCount();
+      for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+        if (interleaved[binNr].mag > interleaved[binNr].magMax) {
+          interleaved[binNr].magMax = interleaved[binNr].mag;
+        }
+      }
+      for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
+        for (uint16_t binNr = sensorData->binGroup[binGroupNr].firstBin; binNr <= sensorData->binGroup[binGroupNr].lastBin; binNr++) {
+          if (interleaved[binNr].mag > (sensorData->binGroup[binGroupNr].magThresh + thresholdOffset)) {
+            interleaved[binNr].magSum += interleaved[binNr].mag * weight;
+            sensorData->binGroup[binGroupNr].magAboveThreshCnt += weight / dropInFOVsnapshots[binNr];
+          }
+        }
+      }
+      cyclesInterleaved += ESP.getCycleCount() - startCycles;
+
+      startCycles = ESP.getCycleCount();
+      statistics->Calc(hop);
+      cyclesCalc += ESP.getCycleCount() - startCycles;
+
+      startCycles = ESP.getCycleCount();
+      statistics->AddQuietSnapshot(hop);
+      cyclesQuiet += ESP.getCycleCount() - startCycles;
+    }
+
+    startCycles = ESP.getCycleCount();
+    statistics->Finalize();
+    cyclesFinalize += ESP.getCycleCount() - startCycles;
+    statistics->Reset();
+
+    m_watchdog->Handle();
+  }
+
+  result += FormatCycles("stat.calc.interleaved", cyclesInterleaved, (uint32_t)iterations * snapshotsPerInterval, NR_OF_BINS);
+  result += FormatCycles("stat.calc", cyclesCalc, (uint32_t)iterations * snapshotsPerInterval, NR_OF_BINS);
+  result += "stat.calc.speedup=" + String(cyclesCalc ? (float)cyclesInterleaved / cyclesCalc : 0, 2) + ",";
+  result += FormatCycles("stat.quiet", cyclesQuiet, (uint32_t)iterations * snapshotsPerInterval, NR_OF_BINS);
+  result += FormatCycles("stat.finalize", cyclesFinalize, iterations, NR_OF_BINS);
+
+  delete[] interleaved;
+  delete[] dropInFOVsnapshots;
+  delete statistics;
+  delete sensorData;
+  return result;
+}
+
+// keeps the compiler from dropping the benchmarked loops
+void Benchmark::Consume(uint16_t *values, uint16_t nrOfValues) {
+  for (uint16_t i = 0; i < nrOfValues; i++) {
+    m_sink += values[i];
+  }
+}
+
+void Benchmark::Consume(uint32_t *values, uint16_t nrOfValues) {
+  for (uint16_t i = 0; i < nrOfValues; i++) {
+    m_sink += values[i];
+  }
+}
+
+// Test signal of all benchmarks: a tone of amplitude 1000 (1 kHz by default) plus noise of amplitude
+// 256. The noise continues from m_noiseState, set it to TOOLS_NOISE_SEED to start the sequence.
+int16_t Benchmark::NextTestSample(uint32_t sampleNr, float sampleRate, float freq) {
+  int16_t tone = 1000 * sinf(2 * PI * freq * sampleNr / sampleRate);
+  return tone + Tools::NextNoise(m_noiseState, 256);
+}
+
+void Benchmark::FillTestSignal(int16_t *re, int16_t *im, uint16_t nrOfSamples) {
+  // at the decimated sample rate, windowed and scaled like in SigProc::Calc()
+  m_noiseState = TOOLS_NOISE_SEED;
+  for (uint16_t n = 0; n < nrOfSamples; n++) {
+    re[n] = NextTestSample(n, SAMPLE_RATE >> 1) << 4;
+    im[n] = 0;
+  }
+  m_sigProc->m_fft.Window(re);
+}
+
+void Benchmark::CalcMagnitudes(int16_t *re, int16_t *im, uint16_t *mag, uint16_t nrOfBins) {
+  for (uint16_t binNr = 0; binNr < nrOfBins; binNr++) {
+    mag[binNr] = sqrt(pow(re[binNr], 2) + pow(im[binNr], 2));
+  }
+}
+
+String Benchmark::CompareMagnitudes(String name, uint16_t *mag, uint16_t *magRef, uint16_t nrOfBins) {
+  uint16_t maxDiff = 0;
+  uint32_t sumDiff = 0;
+  uint16_t binsOff = 0;
+
+  for (uint16_t binNr = 0; binNr < nrOfBins; binNr++) {
+    uint16_t diff = abs((int32_t)mag[binNr] - (int32_t)magRef[binNr]);
+    sumDiff += diff;
+    if (diff > maxDiff) {
+      maxDiff = diff;
+    }
+    if (diff > 1) {
+      binsOff++;
+    }
+  }
+
+  String result;
+  result += name + ".maxMagDiff=" + String(maxDiff) + ",";
+  result += name + ".meanMagDiff=" + String((float)sumDiff / nrOfBins, 3) + ",";
+  result += name + ".binsOff=" + String(binsOff) + ",";
+  return result;
+}
+
+String Benchmark::FormatCycles(String name, uint64_t cycles, uint32_t iterations, uint16_t nrOfSamples) {
+  String result;
+  result += name + ".cycles=" + String((uint32_t)(cycles / iterations)) + ",";
+  result += name + ".ns=" + String((float)cycles / iterations * 1000 / ESP.getCpuFreqMHz(), 0) + ",";
+  result += name + ".cyclesPerSample=" + String((float)cycles / iterations / nrOfSamples, 1) + ",";
+  return result;
+}
@@ -0,0 +1,51 @@
+#ifndef __BENCHMARK__h
+#define __BENCHMARK__h
+
+#include "Arduino.h"
+#include "GlobalDefines.h"
+#include "SigProc.h"
+#include "Watchdog.h"
+#include "Tools.h"
+#include "Magnitude.h"
+#include "Decimator.h"
+#include "SlidingDFT.h"
+#include "HumCanceller.h"
+#include "ZoomFFT.h"
+#include "Statistics.h"
+#include "SensorData.h"
+
+// On-device benchmarks of the signal processing and statistics kernels.
+// Every kernel runs on the same synthetic input (tone + noise), so the results of
+// alternative implementations can be compared in speed and accuracy. Each timing is reported
+// as cycles and ns per call and as cycles per processed sample (or bin).
+class Benchmark {
+public:
+  void Begin(SigProc *sigProc, Watchdog *watchdog);
+  String Run(String params);
+
+private:
+  SigProc *m_sigProc;
+  Watchdog *m_watchdog;
+  uint32_t m_noiseState;
+  volatile uint32_t m_sink;
+
+  String RunFFT(uint16_t iterations);
+  String RunMagnitude(uint16_t iterations);
+  String RunPreprocess(uint16_t iterations);
+  String RunDecimator(uint16_t iterations);
+  String RunSlidingDFT(uint16_t iterations);
+  String RunHumCanceller(uint16_t iterations);
+  String RunWindow(uint16_t iterations);
+  String RunZoom(uint16_t iterations);
+  String RunStatistics(uint16_t iterations);
+
+  void Consume(uint16_t *values, uint16_t nrOfValues);
+  void Consume(uint32_t *values, uint16_t nrOfValues);
+  int16_t NextTestSample(uint32_t sampleNr, float sampleRate, float freq = 1000.0);
+  void FillTestSignal(int16_t *re, int16_t *im, uint16_t nrOfSamples);
+  void CalcMagnitudes(int16_t *re, int16_t *im, uint16_t *mag, uint16_t nrOfBins);
+  static String CompareMagnitudes(String name, uint16_t *mag, uint16_t *magRef, uint16_t nrOfBins);
+  static String FormatCycles(String name, uint64_t cycles, uint32_t iterations, uint16_t nrOfSamples);
+};
+
+#endif
@@ -0,0 +1,58 @@
+#include "Decimator.h"
+
+const int16_t Decimator::FIRcoeff[FILTER_TAP_NUM_HALF] = {
+  -6, 9, 41, 46, -8, -61, -18, 81,
+  69, -80, -138, 41, 211, 48, -262, -189,
+  260, 374, -170, -573, -40, 742, 398, -817,
+  -927, 705, 1682, -240, -2877, -1168, 6090, 13161
+};
+
+void Decimator::Reset() {
+  memset(m_buf, 0, sizeof(m_buf));
+  m_phase = 0;
+}
+
+#define FIR_MAC(k)   sum += FIRcoeff[k] * (x[k] + x[FILTER_TAP_NUM - 1 - (k)])
+
+// x[0 ... FILTER_TAP_NUM-1], newest sample last
+inline int32_t Decimator::MAC(const int16_t *x) {
+  int32_t sum = 0;
+
+  FIR_MAC(0);  FIR_MAC(1);  FIR_MAC(2);  FIR_MAC(3);  FIR_MAC(4);  FIR_MAC(5);  FIR_MAC(6);  FIR_MAC(7);
+  FIR_MAC(8);  FIR_MAC(9);  FIR_MAC(10); FIR_MAC(11); FIR_MAC(12); FIR_MAC(13); FIR_MAC(14); FIR_MAC(15);
+  FIR_MAC(16); FIR_MAC(17); FIR_MAC(18); FIR_MAC(19); FIR_MAC(20); FIR_MAC(21); FIR_MAC(22); FIR_MAC(23);
+  FIR_MAC(24); FIR_MAC(25); FIR_MAC(26); FIR_MAC(27); FIR_MAC(28); FIR_MAC(29); FIR_MAC(30); FIR_MAC(31);
+
+  return sum;
+}
+
+// Filters count raw ADC values and writes the decimated samples to out (at most count/2 + 1).
+// Returns the number of decimated samples. The output phase continues across calls.
+uint16_t Decimator::Process(const uint16_t *in, uint16_t count, int16_t *out) {
+  int16_t *x = &m_buf[FILTER_TAP_NUM - 1];
+  uint16_t chunk;
+  uint16_t outCount = 0;
+
+  while (count) {
+    chunk = (count > DECIMATOR_BLOCK_SIZE) ? DECIMATOR_BLOCK_SIZE : count;
+
+    for (uint16_t i = 0; i < chunk; i++) {
+      x[i] = in[i] - 2048;
+    }
+
+    // an output sample follows every odd input sample
+    for (uint16_t i = 1 - m_phase; i < chunk; i += 2) {
+      out[outCount++] = MAC(&m_buf[i]) >> 15;
+    }
+
+    m_phase = (m_phase + chunk) & 0x01;
+
+    // keep the last FILTER_TAP_NUM - 1 samples as history of the next chunk
+    memmove(m_buf, &m_buf[chunk], (FILTER_TAP_NUM - 1) * sizeof(int16_t));
+
+    in += chunk;
+    count -= chunk;
+  }
+
+  return outCount;
+}
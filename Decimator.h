@@ -0,0 +1,30 @@
+#ifndef __DECIMATOR__h
+#define __DECIMATOR__h
+
+#include "Arduino.h"
+
+// 0 Hz - 8000 Hz, gain = 1, ripple = 0.1 dB
+// 10220 Hz - 20480 Hz, gain = 0, attenuation = -73 dB
+#define FILTER_TAP_NUM             64
+#define FILTER_TAP_NUM_HALF        (FILTER_TAP_NUM >> 1)
+
+#define DECIMATOR_BLOCK_SIZE       256        // raw samples processed per pass
+
+// 2x decimation of raw 12 bit ADC values by a symmetric 64 tap FIR, block by block in task context.
+// Only the retained (odd) output phase is computed. The history is kept in a linear buffer in
+// front of the block, so the unrolled MAC runs without any index wrapping.
+class Decimator {
+public:
+  static const int16_t FIRcoeff[FILTER_TAP_NUM_HALF];
+
+  void Reset();
+  uint16_t Process(const uint16_t *in, uint16_t count, int16_t *out);
+
+private:
+  int16_t m_buf[FILTER_TAP_NUM - 1 + DECIMATOR_BLOCK_SIZE];
+  uint8_t m_phase;
+
+  static inline int32_t MAC(const int16_t *x);
+};
+
+#endif
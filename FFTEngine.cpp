@@ -0,0 +1,327 @@
+#include "FFTEngine.h"
+#include "GlobalDefines.h"
+
+template<uint8_t BITS>
+void FFTEngine<BITS>::Begin(WindowType windowType) {
+  // Q15 cosine, truncated towards +inf for negative values (identical to the former hand written 1024 point table)
+  for (uint16_t i = 0; i < N - N_QUARTER; i++) {
+    double value = 32767.0 * cos(2.0 * PI * i / N);
+    m_cosTable[i] = (int16_t)value + (value < 0 ? 1 : 0);
+  }
+
+  // Q15 periodic Hann window, rounded. Its spectrum has only three non-zero lines (0 and +-1),
+  // which allows to remove a DC offset after the transform (see RemoveDC()).
+  // The symmetric window (N - 1) is the one of the former implementation, for calibrations made with it.
+  m_windowType = windowType;
+  if (windowType == WINDOW_SYMMETRIC) {
+    for (uint16_t n = 0; n < N_HALF; n++) {
+      m_window[n] = round(32767.0 * 0.5 * (1.0 - cos(2.0 * PI * n / (N - 1))));
+      m_window[N - 1 - n] = m_window[n];
+    }
+  } else {
+    for (uint16_t n = 0; n < N; n++) {
+      m_window[n] = round(32767.0 * 0.5 * (1.0 - cos(2.0 * PI * n / N)));
+    }
+  }
+
+  m_bitRevSwapHalfCnt = BuildBitRevTable(BITS - 1, m_bitRevSwapHalf);
+  m_bitRevSwapCnt = BuildBitRevTable(BITS, m_bitRevSwap);
+}
+
+template<uint8_t BITS>
+uint16_t FFTEngine<BITS>::BuildBitRevTable(uint8_t m, uint16_t *swap) {
+  uint16_t reversed;
+  uint16_t swapCnt = 0;
+
+  for (uint16_t i = 1; i < (1 << m) - 1; i++) {
+    reversed = 0;
+    for (uint8_t bit = 0; bit < m; bit++) {
+      if (i & (1 << bit)) {
+        reversed |= 1 << (m - 1 - bit);
+      }
+    }
+    // store every pair only once
+    if (reversed > i) {
+      *swap++ = i;
+      *swap++ = reversed;
+      swapCnt++;
+    }
+  }
+
+  return swapCnt;
+}
+
+template<uint8_t BITS>
+inline int16_t FFTEngine<BITS>::Half(int16_t a) {
+  if (a < 0) {
+    a++;
+  }
+  return a >> 1;
+}
+
+template<uint8_t BITS>
+void FFTEngine<BITS>::Window(int16_t *re) {
+  for (uint16_t n = 0; n < N; n++) {
+    re[n] = MAS(re[n], m_window[n]);
+  }
+}
+
+// Removes a constant offset dc (scale of the FFT input) from the spectrum of a Hann windowed signal.
+// The windowed constant transforms to dc/2 in bin 0 and -dc/4 in bin 1 (and N-1), scaled by 1/N.
+// Only the real part is affected, the window is even.
+template<uint8_t BITS>
+void FFTEngine<BITS>::RemoveDC(int16_t *re, int16_t dc) {
+  re[0] -= dc >> 1;
+  re[1] += dc >> 2;
+}
+
+template<uint8_t BITS>
+void FFTEngine<BITS>::BitReverse(int16_t *fr, int16_t *fi, uint16_t *swap, uint16_t swapCnt) {
+  int16_t tmp;
+
+  while (swapCnt--) {
+    uint16_t x = *swap++;
+    uint16_t y = *swap++;
+
+    tmp = fr[x];
+    fr[x] = fr[y];
+    fr[y] = tmp;
+
+    tmp = fi[x];
+    fi[x] = fi[y];
+    fi[y] = tmp;
+  }
+}
+
+template<uint8_t BITS>
+void FFTEngine<BITS>::FFT(int16_t *fr, int16_t *fi) {
+  BitReverse(fr, fi, m_bitRevSwap, m_bitRevSwapCnt);
+  Transform<BITS>(fr, fi);
+}
+
+// Radix-2 DIT butterflies of a 2^M point transform (M = BITS or BITS - 1) on bit reversed input.
+// Two consecutive radix-2 stages are merged into one radix-4 pass, the twiddle factor of the
+// second butterfly of the second stage is derived from the first one (W^(n+l) = -j * W^n),
+// which saves one of the four complex multiplications.
+template<uint8_t BITS>
+template<uint8_t M>
+void FFTEngine<BITS>::Transform(int16_t *fr, int16_t *fi) {
+  const uint16_t size = 1 << M;
+  uint16_t l;
+  uint16_t i;
+  uint16_t istep;
+  uint8_t k;
+  int16_t ar, ai, br, bi, cr, ci, dr, di;
+  int16_t tr, ti;
+  int16_t waR, waI, wbR, wbI;
+
+  l = 1;
+  k = BITS - 1;
+
+  // odd number of stages: single radix-2 stage with W = 1
+  if (M & 0x01) {
+    waR = m_cosTable[0] >> 1;
+    for (i = 0; i < size; i += 2) {
+      tr = MAS(waR, fr[i + 1]);
+      ti = MAS(waR, fi[i + 1]);
+      ar = Half(fr[i]);
+      ai = Half(fi[i]);
+      fr[i + 1] = ar - tr;
+      fi[i + 1] = ai - ti;
+      fr[i] = ar + tr;
+      fi[i] = ai + ti;
+    }
+    l = 2;
+    k--;
+  }
+
+  // merged stages l and 2l
+  while (l < size) {
+    istep = l << 2;
+
+    for (uint16_t n = 0; n < l; n++) {
+      waR = m_cosTable[n << k] >> 1;
+      waI = m_cosTable[N_QUARTER + (n << k)] >> 1;
+      wbR = m_cosTable[n << (k - 1)] >> 1;
+      wbI = m_cosTable[N_QUARTER + (n << (k - 1))] >> 1;
+
+      for (i = n; i < size; i += istep) {
+        uint16_t ib = i + l;
+        uint16_t ic = ib + l;
+        uint16_t id = ic + l;
+
+        // first stage: (a, b) and (c, d) with W_2l^n
+        tr = MAS(waR, fr[ib]) - MAS(waI, fi[ib]);
+        ti = MAS(waR, fi[ib]) + MAS(waI, fr[ib]);
+        ar = Half(fr[i]);
+        ai = Half(fi[i]);
+        br = ar - tr;
+        bi = ai - ti;
+        ar += tr;
+        ai += ti;
+
+        tr = MAS(waR, fr[id]) - MAS(waI, fi[id]);
+        ti = MAS(waR, fi[id]) + MAS(waI, fr[id]);
+        cr = Half(fr[ic]);
+        ci = Half(fi[ic]);
+        dr = cr - tr;
+        di = ci - ti;
+        cr += tr;
+        ci += ti;
+
+        // second stage: (a, c) with W_4l^n and (b, d) with W_4l^(n+l) = -j * W_4l^n
+        tr = MAS(wbR, cr) - MAS(wbI, ci);
+        ti = MAS(wbR, ci) + MAS(wbI, cr);
+        ar = Half(ar);
+        ai = Half(ai);
+        fr[ic] = ar - tr;
+        fi[ic] = ai - ti;
+        fr[i] = ar + tr;
+        fi[i] = ai + ti;
+
+        tr = MAS(wbR, di) + MAS(wbI, dr);
+        ti = MAS(wbI, di) - MAS(wbR, dr);
+        br = Half(br);
+        bi = Half(bi);
+        fr[id] = br - tr;
+        fi[id] = bi - ti;
+        fr[ib] = br + tr;
+        fi[ib] = bi + ti;
+      }
+    }
+
+    k -= 2;
+    l = istep;
+  }
+}
+
+// Former radix-2 kernel, kept as reference for benchmarks and accuracy checks
+template<uint8_t BITS>
+void FFTEngine<BITS>::FFTRadix2(int16_t *fr, int16_t *fi) {
+  uint16_t mr;
+  uint16_t l; 
+  uint16_t i;
+  uint16_t j;
+  uint16_t m;
+  uint8_t k;
+  uint16_t istep;
+  int16_t qr, qi, tr, ti, wr, wi;
+
+  mr = 0;
+
+  for (m = 1; m <= N - 1; m++) {
+    l = N;
+
+    do {
+      l >>= 1;
+    } while ((mr + l) > N - 1);
+
+    mr = (mr & (l - 1)) + l;
+
+    if (mr <= m) {
+      continue;
+    }
+
+    tr = fr[m];
+    fr[m] = fr[mr];
+    fr[mr] = tr;
+    
+    ti = fi[m];
+    fi[m] = fi[mr];
+    fi[mr] = ti;
+  }
+
+  l = 1;    
+  k = BITS - 1;
+
+  while (l < N) {
+    istep = l << 1;
+
+    for (m = 0; m < l; m++) {
+      j = m << k;
+
+      wr = m_cosTable[j] >> 1;
+      wi = m_cosTable[N_QUARTER + j] >> 1;
+
+      for (i = m; i < N; i += istep) {
+        j = i + l;
+          
+        tr = MAS(wr, fr[j]) - MAS(wi, fi[j]);
+        ti = MAS(wr, fi[j]) + MAS(wi, fr[j]);
+          
+        qr = Half(fr[i]);
+        qi = Half(fi[i]);
+
+        fr[j] = qr - tr;
+        fi[j] = qi - ti;
+        fr[i] = qr + tr;
+        fi[i] = qi + ti;
+      }
+    }
+
+    k--;
+    l = istep;
+  }
+}
+
+// FFT of N real samples, computed as N/2 point complex FFT plus split stage.
+// Input: real samples in re[0 ... N-1], im is used as work area
+// Output: bins 0 ... N/2-1 in re/im, same scaling (1/N) as FFT()
+template<uint8_t BITS>
+void FFTEngine<BITS>::RealFFT(int16_t *re, int16_t *im) {
+  // pack the even samples into the real part and the odd samples into the imaginary part
+  for (uint16_t n = 0; n < N_HALF; n++) {
+    im[n] = re[(n << 1) + 1];
+    re[n] = re[n << 1];
+  }
+
+  RealFFTPacked(re, im);
+}
+
+// Same as RealFFT(), but the input is already packed:
+// even samples in re[0 ... N/2-1], odd samples in im[0 ... N/2-1]
+template<uint8_t BITS>
+void FFTEngine<BITS>::RealFFTPacked(int16_t *re, int16_t *im) {
+  const uint16_t M = N_HALF;
+  int32_t sr, si, dr, di;
+  int32_t foR, foI;
+  int32_t pr, pi;
+  int16_t wr, wi;
+
+  BitReverse(re, im, m_bitRevSwapHalf, m_bitRevSwapHalfCnt);
+  Transform<BITS - 1>(re, im);
+
+  // split the M point spectrum Z into the N point spectrum X of the real sequence:
+  // X[k] = (Fe[k] + W^k * Fo[k]) / 2, with Fe[k] = (Z[k] + Z*[M-k]) / 2, Fo[k] = (Z[k] - Z*[M-k]) / 2j
+  // X[M-k] follows from the same terms: X[M-k] = (Fe[k] - W^k * Fo[k])* / 2
+
+  // k = 0 (Z[M] == Z[0])
+  re[0] = (re[0] + im[0]) >> 1;
+  im[0] = 0;
+
+  for (uint16_t k = 1; k <= (M >> 1); k++) {
+    sr = re[k] + re[M - k];
+    dr = re[k] - re[M - k];
+    si = im[k] + im[M - k];
+    di = im[k] - im[M - k];
+
+    foR = si >> 1;
+    foI = -dr >> 1;
+
+    wr = m_cosTable[k];
+    wi = m_cosTable[N_QUARTER + k];
+
+    pr = (wr * foR - wi * foI) >> 15;
+    pi = (wr * foI + wi * foR) >> 15;
+
+    re[k] = (sr + (pr << 1)) >> 2;
+    im[k] = (di + (pi << 1)) >> 2;
+
+    if (k != (M - k)) {
+      re[M - k] = (sr - (pr << 1)) >> 2;
+      im[M - k] = -((di - (pi << 1)) >> 2);
+    }
+  }
+}
+
+template class FFTEngine<NR_OF_FFT_SAMPLES_bit>;
@@ -0,0 +1,60 @@
+#ifndef __FFTENGINE__h
+#define __FFTENGINE__h
+
+#include "Arduino.h"
+
+// Fixed-point FFT engine for 2^BITS points.
+// All loop bounds are compile time constants, the twiddle, window and bit reversal tables
+// are generated for the transform size in Begin(), so no table has to be edited by hand
+// when NR_OF_FFT_SAMPLES_bit changes.
+// Every radix-2 stage scales by 1/2, the output of all transforms is scaled by 1/N.
+template<uint8_t BITS>
+class FFTEngine {
+public:
+  static const uint16_t N = 1 << BITS;
+  static const uint16_t BINS = N >> 1;
+
+  enum WindowType {
+    WINDOW_PERIODIC,      // DC offset removable after the transform (RemoveDC())
+    WINDOW_SYMMETRIC      // former window, the DC offset has to be removed before windowing
+  };
+
+  void Begin(WindowType windowType = WINDOW_SYMMETRIC);
+  void Window(int16_t *re);
+  const int16_t *WindowTable() { return m_window; }
+  WindowType GetWindowType() { return m_windowType; }
+  void RemoveDC(int16_t *re, int16_t dc);
+  void FFT(int16_t *fr, int16_t *fi);
+  void FFTRadix2(int16_t *fr, int16_t *fi);
+  void RealFFT(int16_t *re, int16_t *im);
+  void RealFFTPacked(int16_t *re, int16_t *im);
+
+  // Q15 multiplication, rounded towards zero
+  static inline int16_t MAS(int16_t a, int16_t b) {
+    int16_t c;
+    c = ((int32_t)a * (int32_t)b) >> 15;
+    if (c < 0) {
+      c++;
+    }
+    return c;
+  }
+
+private:
+  static const uint16_t N_HALF = N >> 1;
+  static const uint16_t N_QUARTER = N >> 2;
+
+  int16_t m_cosTable[N - N_QUARTER];      // 3/4 cosine wave, -sin(x) = cos(x + PI/2)
+  int16_t m_window[N];                    // Hann window
+  WindowType m_windowType;
+  uint16_t m_bitRevSwapHalf[N_HALF];      // swap pairs of the N/2 point transform (real FFT)
+  uint16_t m_bitRevSwap[N];               // swap pairs of the N point transform
+  uint16_t m_bitRevSwapHalfCnt;
+  uint16_t m_bitRevSwapCnt;
+
+  template<uint8_t M> void Transform(int16_t *fr, int16_t *fi);
+  void BitReverse(int16_t *fr, int16_t *fi, uint16_t *swap, uint16_t swapCnt);
+  static uint16_t BuildBitRevTable(uint8_t m, uint16_t *swap);
+  static inline int16_t Half(int16_t a);
+};
+
+#endif
@@ -16,11 +16,26 @@
 #define DEBUG_GPIO_MAIN                   23
 
 #define SAMPLE_RATE                       40960                              // DO NOT MODIFY
-#define NR_OF_FFT_SAMPLES_bit             10                                 // DO NOT MODIFY
+#ifndef NR_OF_FFT_SAMPLES_bit                                                // the host build sets it (FFT_SAMPLES_BIT)
+#define NR_OF_FFT_SAMPLES_bit             10                                 // 9, 10 or 11 (512, 1024 or 2048 points)
+#endif
+#if NR_OF_FFT_SAMPLES_bit < 9 || NR_OF_FFT_SAMPLES_bit > 11
+#error "NR_OF_FFT_SAMPLES_bit: only 9, 10 and 11 are verified by the accuracy test (accuracy=all)"
+#endif
 #define NR_OF_FFT_SAMPLES                 (1 << NR_OF_FFT_SAMPLES_bit)
 #define NR_OF_BINS                        (NR_OF_FFT_SAMPLES >> 1)
 #define NR_OF_BIN_GROUPS                  32
 
+#define BIN_RESOLUTION                    ((float)(SAMPLE_RATE >> 1) / NR_OF_FFT_SAMPLES)          // Hz per bin
+#define SNAPSHOTS_PER_SECOND              ((SAMPLE_RATE >> 1) / (NR_OF_FFT_SAMPLES >> 1))          // 50 % overlap
+
+// Converts the (upper) bin number of a 1024 point FFT to the configured FFT size
+#define SCALED_BIN(bin)                   ((((bin) + 1) << NR_OF_FFT_SAMPLES_bit >> 10) - 1)
+
+// Zoom FFT: usable part of the zoom band (decimation filter), uniform groups
+#define NR_OF_ZOOM_BINS                   ((NR_OF_FFT_SAMPLES >> 1) - (NR_OF_FFT_SAMPLES >> 3))
+#define NR_OF_ZOOM_BIN_GROUPS             16
+
 #define RINGBUFFER_SIZE                   (NR_OF_FFT_SAMPLES << 2)
 
 // Hydrometeor classification (EXPERIMENTAL!)
@@ -28,10 +43,10 @@
 #define DOM_GROUP_RAIN_LAST               23                                 // Last binGroup number classified as rain (everything above is hail)
 
 const uint16_t defaultBinGroupBoundary[NR_OF_BIN_GROUPS] = {
-  6, 9, 12, 15, 18, 21, 24, 27,
-  30, 33, 36, 39, 42, 45, 48, 51,
-  54, 57, 60, 63, 66, 69, 72, 75,
-  78, 103, 128, 153, 178, 203, 228, 255
+  SCALED_BIN(6), SCALED_BIN(9), SCALED_BIN(12), SCALED_BIN(15), SCALED_BIN(18), SCALED_BIN(21), SCALED_BIN(24), SCALED_BIN(27),
+  SCALED_BIN(30), SCALED_BIN(33), SCALED_BIN(36), SCALED_BIN(39), SCALED_BIN(42), SCALED_BIN(45), SCALED_BIN(48), SCALED_BIN(51),
+  SCALED_BIN(54), SCALED_BIN(57), SCALED_BIN(60), SCALED_BIN(63), SCALED_BIN(66), SCALED_BIN(69), SCALED_BIN(72), SCALED_BIN(75),
+  SCALED_BIN(78), SCALED_BIN(103), SCALED_BIN(128), SCALED_BIN(153), SCALED_BIN(178), SCALED_BIN(203), SCALED_BIN(228), SCALED_BIN(255)
 };
 
 // EXPERIMENTAL!
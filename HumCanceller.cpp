@@ -0,0 +1,94 @@
+#include "HumCanceller.h"
+
+int16_t HumCanceller::m_sineTable[HUM_SINE_TABLE_SIZE];
+
+// mainsFrequency: 50 or 60 Hz, 0 disables the canceller
+void HumCanceller::Begin(uint16_t mainsFrequency) {
+  m_mainsFrequency = mainsFrequency;
+  m_phaseIncrement = ((uint64_t)mainsFrequency << 32) / (SAMPLE_RATE >> 1);
+
+  for (uint16_t i = 0; i < HUM_SINE_TABLE_SIZE; i++) {
+    m_sineTable[i] = round(32767 * sin(2 * PI * i / HUM_SINE_TABLE_SIZE));
+  }
+
+  Reset();
+}
+
+void HumCanceller::Reset() {
+  m_phase = 0;
+  memset(m_weightCos, 0, sizeof(m_weightCos));
+  memset(m_weightSin, 0, sizeof(m_weightSin));
+  m_dc = 0;
+  m_inputPower = 0;
+  m_outputPower = 0;
+}
+
+bool HumCanceller::IsEnabled() {
+  return m_mainsFrequency != 0;
+}
+
+// Removes the estimated hum from the samples in place and adapts the weights (LMS):
+// y = sum(w * ref), e = x - y, w += 2^-HUM_MU_SHIFT * e * ref
+void HumCanceller::Process(int16_t *samples, uint16_t count) {
+  int16_t refCos[HUM_HARMONICS];
+  int16_t refSin[HUM_HARMONICS];
+  uint32_t harmonicPhase;
+  uint16_t index;
+  int32_t acc;
+  int32_t error;
+  int32_t input;
+
+  for (uint16_t n = 0; n < count; n++) {
+    acc = 0;
+    harmonicPhase = 0;
+    for (uint8_t h = 0; h < HUM_HARMONICS; h++) {
+      harmonicPhase += m_phase;
+      index = harmonicPhase >> (32 - HUM_SINE_TABLE_bit);
+      refSin[h] = m_sineTable[index];
+      refCos[h] = m_sineTable[(index + (HUM_SINE_TABLE_SIZE >> 2)) & (HUM_SINE_TABLE_SIZE - 1)];
+      acc += (m_weightCos[h] >> HUM_WEIGHT_SHIFT) * refCos[h] + (m_weightSin[h] >> HUM_WEIGHT_SHIFT) * refSin[h];
+    }
+    m_phase += m_phaseIncrement;
+
+    input = samples[n];
+    error = input - ((acc + (1 << (29 - HUM_WEIGHT_SHIFT))) >> (30 - HUM_WEIGHT_SHIFT));
+    error = constrain(error, -32768, 32767);
+    samples[n] = error;
+
+    for (uint8_t h = 0; h < HUM_HARMONICS; h++) {
+      m_weightCos[h] += (error * refCos[h]) >> HUM_MU_SHIFT;
+      m_weightSin[h] += (error * refSin[h]) >> HUM_MU_SHIFT;
+    }
+
+    // signal power before and after the canceller, without the ADC offset (time constant 3.2 s)
+    m_dc += ((input << HUM_DC_SHIFT) - m_dc) >> HUM_DC_SHIFT;
+    input -= m_dc >> HUM_DC_SHIFT;
+    error -= m_dc >> HUM_DC_SHIFT;
+    m_inputPower += input * input;
+    m_outputPower += error * error;
+  }
+}
+
+// Ratio of the signal power in front of and behind the canceller in dB since the last call
+float HumCanceller::TakeSuppression() {
+  float suppression = 0;
+
+  if (m_outputPower > 0) {
+    suppression = 10 * log10f((float)m_inputPower / m_outputPower);
+  }
+  m_inputPower = 0;
+  m_outputPower = 0;
+
+  return suppression;
+}
+
+// Estimated hum amplitude (sum over all harmonics) in ADC steps
+uint16_t HumCanceller::GetAmplitude() {
+  float amplitude = 0;
+
+  for (uint8_t h = 0; h < HUM_HARMONICS; h++) {
+    amplitude += sqrtf((float)m_weightCos[h] * m_weightCos[h] + (float)m_weightSin[h] * m_weightSin[h]) / 32768;
+  }
+
+  return amplitude;
+}
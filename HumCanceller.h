@@ -0,0 +1,39 @@
+#ifndef __HUMCANCELLER__h
+#define __HUMCANCELLER__h
+
+#include "Arduino.h"
+#include "GlobalDefines.h"
+
+#define HUM_HARMONICS              8          // fundamental and harmonics up to 400 Hz (50 Hz) / 480 Hz (60 Hz)
+#define HUM_MU_SHIFT               9          // LMS step size 2^-9: time constant 50 ms, notch width approx. 6 Hz
+#define HUM_SINE_TABLE_bit         10
+#define HUM_SINE_TABLE_SIZE        (1 << HUM_SINE_TABLE_bit)
+#define HUM_DC_SHIFT               16         // ADC offset low pass of the suppression measurement
+#define HUM_WEIGHT_SHIFT           11         // weights Q15, reduced to Q4 for the multiplication with the Q15 reference
+
+// Adaptive mains hum canceller for the decimated sample stream, fixed point only.
+// A pair of LMS weights per harmonic (cos and sin reference of a phase accumulator) estimates the
+// hum, which is subtracted from the signal. Small deviations of the mains frequency are tracked by
+// the weights rotating slowly. Signals more than a few Hz away from a harmonic are not affected.
+class HumCanceller {
+public:
+  void Begin(uint16_t mainsFrequency);
+  void Reset();
+  bool IsEnabled();
+  void Process(int16_t *samples, uint16_t count);
+  float TakeSuppression();
+  uint16_t GetAmplitude();
+
+private:
+  static int16_t m_sineTable[HUM_SINE_TABLE_SIZE];
+  uint16_t m_mainsFrequency;
+  uint32_t m_phaseIncrement;
+  uint32_t m_phase;
+  int32_t m_weightCos[HUM_HARMONICS];
+  int32_t m_weightSin[HUM_HARMONICS];
+  int32_t m_dc;                         // ADC offset << HUM_DC_SHIFT
+  uint64_t m_inputPower;                // suppression measurement since the last TakeSuppression()
+  uint64_t m_outputPower;
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "I2SSampleSource.h"
+
+bool I2SSampleSource::Begin(uint8_t adcPin, BlockHandler blockHandler) {
+  int8_t channel = digitalPinToAnalogChannel(adcPin);
+
+  m_blockHandler = blockHandler;
+
+  // the driver is installed once, a second installation would fail
+  if (m_isInstalled) {
+    return true;
+  }
+
+  // the I2S peripheral can only be connected to ADC1 (channels 0 ... 7)
+  if ((channel < 0) || (channel > 7)) {
+    return false;
+  }
+
+  i2s_config_t config = {
+    .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN),
+    .sample_rate = SAMPLE_RATE,
+    .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+    .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
+    .communication_format = I2S_COMM_FORMAT_I2S_MSB,
+    .intr_alloc_flags = 0,
+    .dma_buf_count = I2S_ADC_DMA_BUF_COUNT,
+    .dma_buf_len = I2S_ADC_DMA_BUF_LEN,
+    .use_apll = false,
+    .tx_desc_auto_clear = false,
+    .fixed_mclk = 0
+  };
+
+  if (i2s_driver_install(I2S_ADC_PORT, &config, I2S_ADC_EVENT_QUEUE_LEN, &m_eventQueue) != ESP_OK) {
+    return false;
+  }
+
+  adc1_config_width(ADC_WIDTH_BIT_12);
+  adc1_config_channel_atten((adc1_channel_t)channel, ADC_ATTEN_DB_6);
+
+  if (i2s_set_adc_mode(ADC_UNIT_1, (adc1_channel_t)channel) != ESP_OK) {
+    i2s_driver_uninstall(I2S_ADC_PORT);
+    return false;
+  }
+
+  i2s_stop(I2S_ADC_PORT);
+  m_isInstalled = true;
+
+  return true;
+}
+
+void I2SSampleSource::Start() {
+  i2s_event_t event;
+
+  // events of the previous run
+  while (xQueueReceive(m_eventQueue, &event, 0) == pdTRUE) {
+  }
+  m_droppedCount = 0;
+  i2s_zero_dma_buffer(I2S_ADC_PORT);
+  i2s_adc_enable(I2S_ADC_PORT);
+  i2s_start(I2S_ADC_PORT);
+  m_isRunning = true;
+}
+
+void I2SSampleSource::Stop() {
+  if (m_isRunning) {
+    i2s_stop(I2S_ADC_PORT);
+    i2s_adc_disable(I2S_ADC_PORT);
+    m_isRunning = false;
+  }
+}
+
+bool I2SSampleSource::IsRunning() {
+  return m_isRunning;
+}
+
+String I2SSampleSource::Name() {
+  return "i2s";
+}
+
+uint32_t I2SSampleSource::GetDroppedCount() {
+  return m_droppedCount;
+}
+
+void I2SSampleSource::Handle() {
+  size_t bytesRead;
+  uint16_t count;
+  uint16_t tmp;
+  i2s_event_t event;
+
+  if (!m_isRunning) {
+    return;
+  }
+
+  // a full receive queue drops the oldest DMA buffer
+  while (xQueueReceive(m_eventQueue, &event, 0) == pdTRUE) {
+    if (event.type == I2S_EVENT_RX_Q_OVF) {
+      m_droppedCount += I2S_ADC_DMA_BUF_LEN;
+    }
+  }
+
+  // drain all complete blocks, never wait for the DMA
+  do {
+    if (i2s_read(I2S_ADC_PORT, m_block, sizeof(m_block), &bytesRead, 0) != ESP_OK) {
+      return;
+    }
+    count = bytesRead / sizeof(uint16_t);
+
+    // the 16 bit samples of each 32 bit DMA word arrive swapped, the upper 4 bits hold the channel number
+    for (uint16_t i = 0; i + 1 < count; i += 2) {
+      tmp = m_block[i] & 0x0FFF;
+      m_block[i] = m_block[i + 1] & 0x0FFF;
+      m_block[i + 1] = tmp;
+    }
+
+    if (count) {
+      m_blockHandler(m_block, count);
+    }
+  } while (count == I2S_ADC_BLOCK_SIZE);
+}
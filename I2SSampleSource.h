@@ -0,0 +1,40 @@
+#ifndef __I2SSAMPLESOURCE__h
+#define __I2SSAMPLESOURCE__h
+
+#include "Arduino.h"
+#include "GlobalDefines.h"
+#include "SampleSource.h"
+#include "driver/i2s.h"
+#include "driver/adc.h"
+
+#define I2S_ADC_PORT                 I2S_NUM_0
+#define I2S_ADC_DMA_BUF_COUNT        8
+#define I2S_ADC_DMA_BUF_LEN          1024     // samples per DMA buffer (maximum), 8 buffers = 200 ms
+#define I2S_ADC_BLOCK_SIZE           256      // samples handed to the decimator at once
+#define I2S_ADC_EVENT_QUEUE_LEN      16       // driver events, drained by Handle()
+
+// Continuous ADC1 sampling by the I2S peripheral in built-in ADC mode. The samples are written to
+// the DMA buffers without any CPU involvement, Handle() drains them in blocks. Only ADC1 pins
+// (GPIO 32 ... 39) can be used.
+// If Handle() is not called for more than 200 ms, the driver overwrites the oldest DMA buffer and
+// reports it by an event (ESP-IDF >= 4.4), the lost samples are counted.
+class I2SSampleSource : public SampleSource {
+public:
+  bool Begin(uint8_t adcPin, BlockHandler blockHandler);
+  void Start();
+  void Stop();
+  void Handle();
+  bool IsRunning();
+  String Name();
+  uint32_t GetDroppedCount();
+
+private:
+  BlockHandler m_blockHandler;
+  uint16_t m_block[I2S_ADC_BLOCK_SIZE];
+  bool m_isInstalled = false;
+  bool m_isRunning = false;
+  QueueHandle_t m_eventQueue = NULL;
+  uint32_t m_droppedCount;
+};
+
+#endif
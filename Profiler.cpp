@@ -0,0 +1,218 @@
+#include "Profiler.h"
+
+Profiler::Span *Profiler::m_spans = NULL;
+uint16_t Profiler::m_capacity = 0;
+volatile uint32_t Profiler::m_next = 0;
+volatile uint32_t Profiler::m_writers = 0;
+volatile bool Profiler::m_recording = false;
+volatile bool Profiler::m_anchorValid[2];
+uint32_t Profiler::m_anchorCycles[2];
+uint32_t Profiler::m_anchorMicros[2];
+int64_t Profiler::m_exportCycles[2];
+uint32_t Profiler::m_exportPrevStart[2];
+double Profiler::m_exportOffset[2];
+
+// Arms a new capture of the last capacity spans (rounded down to a power of two). The buffer is kept
+// for further captures. A running capture is stopped first, so no span is written while the buffer
+// is replaced.
+bool Profiler::Start(uint16_t capacity) {
+  Stop();
+
+  if (capacity == 0 || capacity > PROFILER_MAX_CAPACITY) {
+    capacity = PROFILER_DEFAULT_CAPACITY;
+  }
+  capacity = 1 << (31 - __builtin_clz(capacity));
+  if (capacity != m_capacity) {
+    free(m_spans);
+    m_capacity = 0;
+    m_spans = (Span *)malloc(capacity * sizeof(Span));
+    if (!m_spans) {
+      return false;
+    }
+    m_capacity = capacity;
+  }
+
+  m_anchorValid[0] = false;
+  m_anchorValid[1] = false;
+  m_next = 0;
+  m_recording = true;
+
+  return true;
+}
+
+// Returns when no span is being written anymore. Record() checks m_recording after announcing
+// itself in m_writers, so a writer either sees the stop or is waited for here. Usually there is
+// none, a task interrupted while writing may need a tick to continue.
+void Profiler::Stop() {
+  __atomic_store_n(&m_recording, false, __ATOMIC_SEQ_CST);
+  while (__atomic_load_n(&m_writers, __ATOMIC_SEQ_CST)) {
+    delay(1);
+  }
+}
+
+bool Profiler::IsRecording() {
+  return m_recording;
+}
+
+uint16_t Profiler::GetCount() {
+  return m_next < m_capacity ? m_next : m_capacity;
+}
+
+// ring slot of the oldest span
+uint32_t Profiler::GetFirst() {
+  return m_next < m_capacity ? 0 : m_next & (m_capacity - 1);
+}
+
+String Profiler::GetStatus() {
+  return String(m_recording ? "recording," : "stopped,") + String(GetCount()) + "/" + String(m_capacity);
+}
+
+void IRAM_ATTR Profiler::Record(ProfileStage stage, uint32_t startCycles, uint32_t minCycles) {
+  uint32_t endCycles = xthal_get_ccount();
+  uint32_t idx;
+  uint8_t core;
+
+  if (!m_recording || (endCycles - startCycles < minCycles)) {
+    return;
+  }
+
+  __atomic_fetch_add(&m_writers, 1, __ATOMIC_SEQ_CST);
+  if (!__atomic_load_n(&m_recording, __ATOMIC_SEQ_CST)) {
+    __atomic_fetch_sub(&m_writers, 1, __ATOMIC_RELEASE);
+    return;
+  }
+
+  idx = __atomic_fetch_add(&m_next, 1, __ATOMIC_RELAXED) & (m_capacity - 1);
+
+  // an interrupt on the same core may renew the anchor in between, both pairs are a few us apart
+  core = xPortGetCoreID();
+  if (!m_anchorValid[core] || (endCycles - m_anchorCycles[core] >= PROFILER_ANCHOR_CYCLES)) {
+    m_anchorCycles[core] = endCycles;
+    m_anchorMicros[core] = micros();
+    m_anchorValid[core] = true;
+  }
+
+  m_spans[idx].start = startCycles;
+  m_spans[idx].cycles = endCycles - startCycles;
+  m_spans[idx].stage = stage;
+  m_spans[idx].core = core;
+  __atomic_fetch_sub(&m_writers, 1, __ATOMIC_RELEASE);
+}
+
+void IRAM_ATTR Profiler::Mark(ProfileStage stage) {
+  Record(stage, xthal_get_ccount());
+}
+
+String Profiler::GetStageName(uint8_t stage) {
+  switch (stage) {
+    case PROFILE_ISR: return "onTimer";
+    case PROFILE_DECIMATOR: return "Decimator";
+    case PROFILE_HUM: return "HumCanceller";
+    case PROFILE_NEW_SAMPLES: return "SlidingDFT input";
+    case PROFILE_PREPROCESS: return "Preprocess";
+    case PROFILE_FFT: return "FFT";
+    case PROFILE_MAGNITUDE: return "Magnitude";
+    case PROFILE_STATISTICS: return "Statistics::Calc";
+    case PROFILE_ZOOM: return "ZoomFFT";
+    case PROFILE_FINALIZE: return "Statistics::Finalize";
+    case PROFILE_PUBLISH: return "Publisher::Publish";
+    case PROFILE_DATAPORT: return "DataPort::Handle";
+    case PROFILE_FRONTEND: return "WebFrontend::Handle";
+    case PROFILE_RB_OVERFLOW: return "RbOverflow";
+    default: return "?";
+  }
+}
+
+// Unwraps the cycle counter of each core over the whole capture (32 bit, wraps every 18 s at 240 MHz,
+// consecutive spans of a core are less than 2^31 cycles apart) and places the anchor of the core, the
+// last one taken, in it. The anchor is renewed while recording, so it is close to the last spans.
+// The micros() of the anchors then give the offset of the first span of each core.
+void Profiler::PrepareExport() {
+  uint16_t count = GetCount();
+  uint32_t first = GetFirst();
+  uint32_t mhz = ESP.getCpuFreqMHz();
+  bool seen[2] = { false, false };
+  uint32_t prevStart[2];
+  int64_t cycles[2] = { 0, 0 };
+  uint8_t ref = 0;
+  double origin = 0;
+  Span *span;
+
+  for (uint16_t pos = 0; pos < count; pos++) {
+    span = &m_spans[(first + pos) & (m_capacity - 1)];
+    if (!seen[span->core]) {
+      seen[span->core] = true;
+      prevStart[span->core] = span->start;
+      m_exportPrevStart[span->core] = span->start;
+    }
+    cycles[span->core] += (int32_t)(span->start - prevStart[span->core]);
+    prevStart[span->core] = span->start;
+  }
+
+  ref = seen[0] ? 0 : 1;
+  for (uint8_t core = 0; core < 2; core++) {
+    m_exportCycles[core] = 0;
+    m_exportOffset[core] = 0;
+    if (seen[core]) {
+      m_exportOffset[core] = (int32_t)(m_anchorMicros[core] - m_anchorMicros[ref]) -
+        (double)(cycles[core] + (int32_t)(m_anchorCycles[core] - prevStart[core])) / mhz;
+      if (m_exportOffset[core] < origin || core == ref) {
+        origin = m_exportOffset[core];
+      }
+    }
+  }
+  m_exportOffset[0] -= origin;
+  m_exportOffset[1] -= origin;
+}
+
+// Trace events pos ... pos + PROFILER_TRACE_CHUNK - 1 of the stopped capture, oldest first, wrapped
+// into the JSON document (pos = 0 starts it). Returns an empty string after the last chunk.
+String Profiler::GetTraceChunk(uint16_t &pos) {
+  uint16_t count = GetCount();
+  uint32_t first = GetFirst();
+  uint32_t mhz = ESP.getCpuFreqMHz();
+  uint16_t end;
+  String result;
+  Span span;
+  double ts;
+
+  if (pos > count) {
+    return "";
+  }
+
+  if (pos == 0) {
+    Stop();
+    count = GetCount();
+    first = GetFirst();
+    PrepareExport();
+    result = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    for (uint8_t core = 0; core < 2; core++) {
+      result += String(core > 0 ? "," : "") + "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" +
+        String(core) + ",\"args\":{\"name\":\"core " + String(core) + "\"}}";
+    }
+  }
+
+  end = pos + PROFILER_TRACE_CHUNK < count ? pos + PROFILER_TRACE_CHUNK : count;
+  for (; pos < end; pos++) {
+    span = m_spans[(first + pos) & (m_capacity - 1)];
+    m_exportCycles[span.core] += (int32_t)(span.start - m_exportPrevStart[span.core]);
+    m_exportPrevStart[span.core] = span.start;
+    ts = m_exportOffset[span.core] + (double)m_exportCycles[span.core] / mhz;
+
+    result += ",{\"name\":\"" + GetStageName(span.stage) + "\",\"pid\":1,\"tid\":" + String(span.core) +
+      ",\"ts\":" + String(ts, 3);
+    if (span.stage == PROFILE_RB_OVERFLOW) {
+      result += ",\"ph\":\"i\",\"s\":\"g\"}";
+    } else {
+      result += ",\"ph\":\"X\",\"dur\":" + String((double)span.cycles / mhz, 3) +
+        ",\"args\":{\"cycles\":" + String(span.cycles) + "}}";
+    }
+  }
+
+  if (pos == count) {
+    result += "]}";
+    pos++;
+  }
+
+  return result;
+}
@@ -0,0 +1,80 @@
+#ifndef __PROFILER__h
+#define __PROFILER__h
+
+#include "Arduino.h"
+#include "xtensa/hal.h"
+
+#define PROFILER_DEFAULT_CAPACITY  2048       // spans of one capture, 12 byte each, a power of two
+#define PROFILER_MAX_CAPACITY      8192
+#define PROFILER_ANCHOR_CYCLES     0x40000000 // the time anchor of a core is renewed after 2^30 cycles (4.5 s at 240 MHz)
+#define PROFILER_ISR_DECIMATION    256        // every 256th sampling interrupt is recorded
+#define PROFILER_POLL_MIN_CYCLES   4800       // polled handlers are recorded from 20 us (240 MHz) on
+#define PROFILER_TRACE_CHUNK       64         // trace events per GetTraceChunk() call
+
+enum ProfileStage : uint8_t {
+  PROFILE_ISR,
+  PROFILE_DECIMATOR,
+  PROFILE_HUM,
+  PROFILE_NEW_SAMPLES,
+  PROFILE_PREPROCESS,
+  PROFILE_FFT,
+  PROFILE_MAGNITUDE,
+  PROFILE_STATISTICS,
+  PROFILE_ZOOM,
+  PROFILE_FINALIZE,
+  PROFILE_PUBLISH,
+  PROFILE_DATAPORT,
+  PROFILE_FRONTEND,
+  PROFILE_RB_OVERFLOW,          // instant event
+  PROFILE_NR_OF_STAGES
+};
+
+// Span profiler based on the CPU cycle counter. Start() arms a capture, the instrumented stages
+// record their spans into a lock-free ring until Stop(), the oldest spans are overwritten, so the
+// capture holds the last capacity spans before the stop. The slot is reserved atomically, so the
+// sampling ISR, the processing task and loop() may record concurrently on both cores. Without a
+// capture Record() costs a load and a branch.
+// The capture is exported in Chrome trace-event format (chrome://tracing, Perfetto), one thread per core,
+// oldest span first. The cycle counters of the cores are not synchronized, each core is aligned by a
+// micros() anchor, renewed every PROFILER_ANCHOR_CYCLES, so it stays close to the exported spans.
+class Profiler {
+public:
+  static bool Start(uint16_t capacity = PROFILER_DEFAULT_CAPACITY);
+  static void Stop();
+  static bool IsRecording();
+  static String GetStatus();
+  static String GetTraceChunk(uint16_t &pos);
+
+  static inline uint32_t IRAM_ATTR Now() {
+    return xthal_get_ccount();
+  }
+  static void IRAM_ATTR Record(ProfileStage stage, uint32_t startCycles, uint32_t minCycles = 0);
+  static void IRAM_ATTR Mark(ProfileStage stage);
+
+private:
+  struct Span {
+    uint32_t start;
+    uint32_t cycles;
+    uint8_t stage;
+    uint8_t core;
+  };
+
+  static Span *m_spans;
+  static uint16_t m_capacity;
+  static volatile uint32_t m_next;      // spans recorded since Start(), the slot is m_next & (m_capacity - 1)
+  static volatile uint32_t m_writers;   // Record() calls writing a span
+  static volatile bool m_recording;
+  static volatile bool m_anchorValid[2];
+  static uint32_t m_anchorCycles[2];
+  static uint32_t m_anchorMicros[2];
+  static int64_t m_exportCycles[2];     // unwrapped start of the previous span while exporting
+  static uint32_t m_exportPrevStart[2];
+  static double m_exportOffset[2];      // us from the first exported span to the first one of the core
+
+  static uint16_t GetCount();
+  static uint32_t GetFirst();
+  static void PrepareExport();
+  static String GetStageName(uint8_t stage);
+};
+
+#endif
@@ -36,6 +36,13 @@ void Publisher::SendToDataPort() {
   payload += "ADCpeak=" + String((100 * (m_sensorData->ADCpeakSample > 2048 ? 2048 : m_sensorData->ADCpeakSample)) / 2048) + ",";
   payload += "ADCoffset=" + String(m_sensorData->ADCoffset) + ",";
   payload += "RBoverflows=" + String(m_sensorData->RbOvCtr) + ",";
+  payload += "RBdropped=" + String(m_sensorData->RbDroppedSamples) + ",";
+  payload += "RBhighWater=" + String((100 * m_sensorData->RbHighWater) / RINGBUFFER_SIZE) + ",";
+  payload += "HopWidened=" + String(m_sensorData->hopWidenedCtr) + ",";
+  payload += "SDFTdev=" + String(m_sensorData->sdftMaxDeviation) + ",";
+  payload += "HumSuppr=" + String(m_sensorData->humSuppression, 1) + ",";
+  payload += "HumAmp=" + String(m_sensorData->humAmplitude) + ",";
+  payload += "GateSkip=" + String(m_sensorData->snapshotCtr ? (100 * m_sensorData->gatedSnapshotCtr) / m_sensorData->snapshotCtr : 0) + ",";
   payload += "MagMax=" + String(m_sensorData->magMax) + ",";
   payload += "MagAVG=" + String(m_sensorData->magAVG, 8) + ",";
   payload += "MagAVGkorr=" + String(m_sensorData->magAVGkorr, 8) + ",";
@@ -51,6 +58,9 @@ void Publisher::SendToDataPort() {
   String groupMagAVGkorrDom;
   String groupMagAVGkorrDom2;
   String groupMagThresh;
+  String groupMagQ50;
+  String groupMagQ95;
+  String groupMagQ99;
   String groupMagAboveThreshCnt;
   String groupMagAboveThreshCntDom;
   String Debug0;
@@ -64,13 +74,16 @@ void Publisher::SendToDataPort() {
     groupMagAVGkorrDom += String(m_sensorData->binGroup[i].magAVGkorrDom, 4) + " ";
     groupMagAVGkorrDom2 += String(m_sensorData->binGroup[i].magAVGkorrDom2, 4) + " ";
     groupMagThresh += String(m_sensorData->binGroup[i].magThresh) + " ";
+    groupMagQ50 += String(m_sensorData->binGroup[i].magQ50) + " ";
+    groupMagQ95 += String(m_sensorData->binGroup[i].magQ95) + " ";
+    groupMagQ99 += String(m_sensorData->binGroup[i].magQ99) + " ";
     groupMagAboveThreshCnt += String(m_sensorData->binGroup[i].magAboveThreshCnt, 4) + " ";
     groupMagAboveThreshCntDom += String(m_sensorData->binGroup[i].magAboveThreshCntDom, 4) + " ";
   }
 
-  // output first 32 bins for 50Hz noise analyzation
-  for (byte i = 0; i < 32; i++) {
-    Debug0 += String(m_sensorData->bin[i].magMax) + " ";
+  // output first 32 bins (1024 point FFT, 0 ... 620 Hz) for 50Hz noise analyzation
+  for (uint16_t i = 0; i < (NR_OF_BINS >> 4); i++) {
+    Debug0 += String(m_sensorData->bin.magMax[i]) + " ";
   }
 
   payload += "GroupMagMax=" + groupMagMax + ",";
@@ -80,9 +93,25 @@ void Publisher::SendToDataPort() {
   payload += "GroupMagAVGkorrDom=" + groupMagAVGkorrDom + ",";
   payload += "GroupMagAVGkorrDom2=" + groupMagAVGkorrDom2 + ",";
   payload += "GroupMagThresh=" + groupMagThresh + ",";
+  payload += "GroupMagQ50=" + groupMagQ50 + ",";
+  payload += "GroupMagQ95=" + groupMagQ95 + ",";
+  payload += "GroupMagQ99=" + groupMagQ99 + ",";
   payload += "GroupMagAboveThreshCnt=" + groupMagAboveThreshCnt + ",";
   payload += "GroupMagAboveThreshCntDom=" + groupMagAboveThreshCntDom + ",";
   payload += "Debug0=" + Debug0 + ",";
+
+  if (m_sensorData->zoomBinGroup) {
+    String zoomGroupMagMax;
+    String zoomGroupMagAVG;
+
+    for (byte i = 0; i < NR_OF_ZOOM_BIN_GROUPS; i++) {
+      zoomGroupMagMax += String(m_sensorData->zoomBinGroup[i].magMax) + " ";
+      zoomGroupMagAVG += String(m_sensorData->zoomBinGroup[i].magAVG, 4) + " ";
+    }
+    payload += "ZoomFactor=" + String(m_sensorData->zoomFactor) + ",";
+    payload += "ZoomGroupMagMax=" + zoomGroupMagMax + ",";
+    payload += "ZoomGroupMagAVG=" + zoomGroupMagAVG + ",";
+  }
   
   if (m_bme280->IsPresent()) {
     m_bme280->Measure();
@@ -113,6 +142,11 @@ void Publisher::Publish(SensorData *sensorData) {
     AddCommonReadings();
     AddBinGroupsReadings();
   }
+  if (m_settings->GetBool("PubZG", false) && m_sensorData->zoomBinGroup) {
+    m_dummySuffix = "_ZOOM_GROUPS";
+    AddCommonReadings();
+    AddZoomBinGroupsReadings();
+  }
   if (m_settings->GetBool("PubBMA", false)) {
     m_dummySuffix = "";
     AddBinMagAVGReading();
@@ -157,6 +191,13 @@ void Publisher::AddCommonReadings() {
   AddReading("ADCpeak", (100 * (m_sensorData->ADCpeakSample > 2048 ? 2048 : m_sensorData->ADCpeakSample)) / 2048);
   AddReading("ADCoffset", m_sensorData->ADCoffset);
   AddReading("RBoverflows", m_sensorData->RbOvCtr);
+  AddReading("RBdropped", m_sensorData->RbDroppedSamples);
+  AddReading("RBhighWater", (100 * m_sensorData->RbHighWater) / RINGBUFFER_SIZE);
+  AddReading("HopWidened", m_sensorData->hopWidenedCtr);
+  AddReading("SDFTdev", m_sensorData->sdftMaxDeviation);
+  AddReading("HumSuppr", m_sensorData->humSuppression);
+  AddReading("HumAmp", m_sensorData->humAmplitude);
+  AddReading("GateSkip", m_sensorData->snapshotCtr ? (100 * m_sensorData->gatedSnapshotCtr) / m_sensorData->snapshotCtr : 0);
   AddReading("MagMax", m_sensorData->magMax);
   AddReading("MagAVG", m_sensorData->magAVG);
   AddReading("MagAVGkorr", m_sensorData->magAVGkorr);
@@ -170,8 +211,8 @@ void Publisher::AddBinsMagReadings() {
   // find peak value for scaling
   magMax = 0;
   for (uint16_t binNr = 1; binNr < m_settings->BaseData.NrOfBins; binNr++) {
-    if (m_sensorData->bin[binNr].magMax > magMax) {
-      magMax = m_sensorData->bin[binNr].magMax;
+    if (m_sensorData->bin.magMax[binNr] > magMax) {
+      magMax = m_sensorData->bin.magMax[binNr];
     }
   }
   
@@ -183,7 +224,7 @@ void Publisher::AddBinsMagReadings() {
     String value;
     for (uint8_t x = 0; x < NR_OF_BARS; x++) {
       if (magMax > 0) {
-        if (x < ((NR_OF_BARS * m_sensorData->bin[binNr].magMax) / magMax))
+        if (x < ((NR_OF_BARS * m_sensorData->bin.magMax[binNr]) / magMax))
           value += "|";
         else
           value += ".";
@@ -192,7 +233,7 @@ void Publisher::AddBinsMagReadings() {
       }
     }
   
-    value += "%20" + String(m_sensorData->bin[binNr].magMax);
+    value += "%20" + String(m_sensorData->bin.magMax[binNr]);
   
     AddReading(name, value);
   }
@@ -230,10 +271,40 @@ void Publisher::AddBinGroupsReadings() {
 
 }
 
+void Publisher::AddZoomBinGroupsReadings() {
+  uint16_t magMax;
+  char name[12];
+
+  // find peak value for scaling
+  magMax = 0;
+  for (byte binGroupNr = 0; binGroupNr < NR_OF_ZOOM_BIN_GROUPS; binGroupNr++) {
+    if (m_sensorData->zoomBinGroup[binGroupNr].magMax > magMax) {
+      magMax = m_sensorData->zoomBinGroup[binGroupNr].magMax;
+    }
+  }
+
+  // transfer maximum value of each zoom bin group
+  for (byte binGroupNr = 0; binGroupNr < NR_OF_ZOOM_BIN_GROUPS; binGroupNr++) {
+    sprintf(name, "Z%03d", binGroupNr);
+
+    String value;
+    for (uint8_t x = 0; x < NR_OF_BARS; x++) {
+      if ((x < ((NR_OF_BARS * m_sensorData->zoomBinGroup[binGroupNr].magMax) / magMax)) && (magMax > 0))
+        value += "|";
+      else
+        value += ".";
+    }
+
+    value += "%20" + String(m_sensorData->zoomBinGroup[binGroupNr].magMax);
+
+    AddReading(name, value);
+  }
+}
+
 void Publisher::AddBinMagAVGReading() {
   String binsMagAVG;
   for (uint16_t binNr = 0; binNr < m_settings->BaseData.NrOfBins; binNr++) {
-    binsMagAVG += String(m_sensorData->bin[binNr].magAVG, 4) + "%20";
+    binsMagAVG += String(m_sensorData->bin.magAVG[binNr], 4) + "%20";
   }
   AddReading("BinMagAVG", binsMagAVG);
 }
@@ -241,15 +312,25 @@ void Publisher::AddBinMagAVGReading() {
 void Publisher::AddBinMagAVGkorrReading() {
   String binsMagAVGkorr;
   for (uint16_t binNr = 0; binNr < m_settings->BaseData.NrOfBins; binNr++) {
-    binsMagAVGkorr += String(m_sensorData->bin[binNr].magAVGkorr, 4) + "%20";
+    binsMagAVGkorr += String(m_sensorData->bin.magAVGkorr[binNr], 4) + "%20";
   }
   AddReading("BinMagAVGkorr", binsMagAVGkorr);
 }
 
+// thresholds and the calibration candidates of the last interval (command calibrate=max|q50|q95|q99)
 void Publisher::AddGroupMagCalReading() {
   String groupsMagThresh;
+  String groupsMagQ50;
+  String groupsMagQ95;
+  String groupsMagQ99;
   for (byte binGroupNr = 0; binGroupNr <  m_settings->BaseData.NrOfBinGroups; binGroupNr++) {
     groupsMagThresh += String(m_sensorData->binGroup[binGroupNr].magThresh) + "%20";
+    groupsMagQ50 += String(m_sensorData->binGroup[binGroupNr].magQ50) + "%20";
+    groupsMagQ95 += String(m_sensorData->binGroup[binGroupNr].magQ95) + "%20";
+    groupsMagQ99 += String(m_sensorData->binGroup[binGroupNr].magQ99) + "%20";
   }
   AddReading("groupsMagThresh", groupsMagThresh);
-}
+  AddReading("groupsMagQ50", groupsMagQ50);
+  AddReading("groupsMagQ95", groupsMagQ95);
+  AddReading("groupsMagQ99", groupsMagQ99);
+}
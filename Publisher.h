@@ -9,6 +9,7 @@
 #include "StateManager.h"
 #include "DataPort.h"
 #include "BME280.h"
+#include "GlobalDefines.h"
 
 #define NR_OF_BARS 32
 
@@ -37,6 +38,7 @@ private:
   void AddBinsCountReadings();
   void AddBinsMagReadings();
   void AddBinGroupsReadings();
+  void AddZoomBinGroupsReadings();
   void AddBinMagAVGReading();
   void AddBinMagAVGkorrReading();
   void AddBinMagAVGkorrThreshReading();
@@ -0,0 +1,194 @@
+#include "Replay.h"
+
+void Replay::Begin(SigProc *sigProc, Statistics *statistics, SensorData *sensorData, Watchdog *watchdog) {
+  m_sigProc = sigProc;
+  m_statistics = statistics;
+  m_sensorData = sensorData;
+  m_watchdog = watchdog;
+}
+
+// params: <tone|chirp|noise|burst|silence>,<seconds>,<freq1>,<freq2>,<amplitude>
+// e.g. "tone,5,1000,0,1000" or "chirp,10,20,8000,500"
+String Replay::Run(String params) {
+  SignalType type;
+  uint32_t nrOfSamples;
+  uint32_t snapshots;
+  uint64_t cycles;
+  uint64_t processCycles;
+  uint64_t acquireCycles;
+  uint32_t startCycles;
+  bool wasCapturing;
+  uint16_t block[REPLAY_BLOCK_SIZE];
+  String result;
+
+  if (!ParseSignalType(Tools::GetParam(params, 0, "tone"), &type)) {
+    return "replay=invalid signal type";
+  }
+
+  uint seconds = Tools::GetParam(params, 1, "5").toInt();
+  float freq1 = Tools::GetParam(params, 2, "1000").toFloat();
+  float freq2 = Tools::GetParam(params, 3, "0").toFloat();
+  uint16_t amplitude = Tools::GetParam(params, 4, "1000").toInt();
+
+  if (seconds < 1 || seconds > REPLAY_MAX_SECONDS) {
+    return "replay=seconds must be in the range 1 ... " + String(REPLAY_MAX_SECONDS);
+  }
+  if (amplitude > 2047) {
+    amplitude = 2047;
+  }
+
+  wasCapturing = m_sigProc->IsCapturing();
+  m_sigProc->StopCapture();
+  m_sigProc->ResetCapture();
+  m_statistics->Reset();
+  m_noiseState = TOOLS_NOISE_SEED;
+
+  nrOfSamples = seconds * SAMPLE_RATE;
+  snapshots = 0;
+  processCycles = 0;
+  acquireCycles = 0;
+
+  for (uint32_t sampleNr = 0; sampleNr < nrOfSamples; sampleNr += REPLAY_BLOCK_SIZE) {
+    for (uint16_t i = 0; i < REPLAY_BLOCK_SIZE; i++) {
+      block[i] = NextSample(type, sampleNr + i, nrOfSamples, freq1, freq2, amplitude);
+    }
+
+    startCycles = ESP.getCycleCount();
+    SigProc::AddRawBlock(block, REPLAY_BLOCK_SIZE);
+    acquireCycles += ESP.getCycleCount() - startCycles;
+
+    if ((sampleNr & 0x0FFF) == 0) {
+      m_watchdog->Handle();
+      yield();
+    }
+
+    // like StartCapture(), wait for the first complete snapshot before processing
+    if (sampleNr < (NR_OF_FFT_SAMPLES << 1)) {
+      continue;
+    }
+
+    while (m_sigProc->SnapPending()) {
+      startCycles = ESP.getCycleCount();
+      m_sigProc->ProcessSnapshot();
+      processCycles += ESP.getCycleCount() - startCycles;
+      snapshots++;
+    }
+  }
+
+  m_statistics->Finalize();
+  m_sigProc->TakeHumStatistics();
+
+  cycles = processCycles + acquireCycles;
+  result = "replay=";
+  result += "samples=" + String(nrOfSamples) + ",";
+  result += "snapshots=" + String(snapshots) + ",";
+  result += "validSnapshots=" + String(m_sensorData->snapshotValidCtr) + ",";
+  result += "gatedSnapshots=" + String(m_sensorData->gatedSnapshotCtr) + ",";
+  result += "sdftDeviation=" + String(m_sensorData->sdftMaxDeviation) + ",";
+  result += "humSuppression=" + String(m_sensorData->humSuppression, 1) + ",";
+  result += "humAmplitude=" + String(m_sensorData->humAmplitude) + ",";
+  if (m_sensorData->zoomBinGroup) {
+    result += "zoomSnapshots=" + String(m_sensorData->zoomSnapshotCtr) + ",";
+    result += "zoomPeak=" + String(ZoomPeakFrequency(), 1) + ",";
+  }
+  result += "clipping=" + String(m_sensorData->clippingCtr) + ",";
+  result += "acquireCyclesPerSample=" + String((float)acquireCycles / nrOfSamples, 1) + ",";
+  result += "processCyclesPerSnapshot=" + String(snapshots ? (uint32_t)(processCycles / snapshots) : 0) + ",";
+  result += "snapshotsPerSecond=" + String(cycles ? (float)snapshots * CPU_CLOCK / cycles : 0, 1) + ",";
+  result += "cpuLoad=" + String(100.0 * cycles / ((float)seconds * CPU_CLOCK), 1) + ",";
+  result += "magMax=" + String(m_sensorData->magMax) + ",";
+  result += "domGroup=" + String(m_sensorData->DomGroupMagAVGkorr) + ",";
+  result += "checksum=" + String(Checksum(), HEX);
+
+  // the replayed data must not show up in the next published interval
+  m_statistics->Reset();
+  m_sigProc->ResetCapture();
+  if (wasCapturing) {
+    m_sigProc->StartCapture();
+  }
+
+  return result;
+}
+
+uint16_t Replay::NextSample(SignalType type, uint32_t sampleNr, uint32_t nrOfSamples, float freq1, float freq2, uint16_t amplitude) {
+  double t = (double)sampleNr / SAMPLE_RATE;
+  double cycles;
+  float value;
+
+  switch (type) {
+  case SIGNAL_TONE:
+    cycles = freq1 * t;
+    value = amplitude * sinf(2 * PI * (cycles - floor(cycles)));
+    break;
+  case SIGNAL_CHIRP:
+    // linear sweep from freq1 to freq2 over the whole replay duration
+    cycles = (freq1 + (freq2 - freq1) * sampleNr / (2.0 * nrOfSamples)) * t;
+    value = amplitude * sinf(2 * PI * (cycles - floor(cycles)));
+    break;
+  case SIGNAL_NOISE:
+    value = Tools::NextNoise(m_noiseState, amplitude);
+    break;
+  case SIGNAL_BURST:
+    // linear sweep from freq1 to freq2 over the first half, every bin gets a maximum above the silence
+    cycles = (freq1 + (freq2 - freq1) * sampleNr / (double)nrOfSamples) * t;
+    value = sampleNr < (nrOfSamples >> 1) ? amplitude * sinf(2 * PI * (cycles - floor(cycles))) : 0;
+    break;
+  default:
+    value = 0;
+    break;
+  }
+
+  return 2048 + (int16_t)value;
+}
+
+// frequency of the zoom bin with the highest average magnitude (Hz)
+float Replay::ZoomPeakFrequency() {
+  uint16_t peakBin = 1;
+
+  for (uint16_t binNr = 2; binNr < NR_OF_ZOOM_BINS; binNr++) {
+    if (m_sensorData->zoomBin.magAVG[binNr] > m_sensorData->zoomBin.magAVG[peakBin]) {
+      peakBin = binNr;
+    }
+  }
+
+  return peakBin * BIN_RESOLUTION / m_sensorData->zoomFactor;
+}
+
+uint32_t Replay::Checksum() {
+  // FNV-1a over the integer results of the interval
+  uint32_t hash = 2166136261;
+
+  for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+    hash = (hash ^ (m_sensorData->bin.magMax[binNr] & 0xFF)) * 16777619;
+    hash = (hash ^ (m_sensorData->bin.magMax[binNr] >> 8)) * 16777619;
+  }
+  for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
+    hash = (hash ^ (m_sensorData->binGroup[binGroupNr].magMax & 0xFF)) * 16777619;
+    hash = (hash ^ (m_sensorData->binGroup[binGroupNr].magMax >> 8)) * 16777619;
+  }
+
+  return hash;
+}
+
+bool Replay::ParseSignalType(String name, SignalType *type) {
+  name.trim();
+  if (name == "tone") {
+    *type = SIGNAL_TONE;
+  }
+  else if (name == "chirp") {
+    *type = SIGNAL_CHIRP;
+  }
+  else if (name == "noise") {
+    *type = SIGNAL_NOISE;
+  }
+  else if (name == "burst") {
+    *type = SIGNAL_BURST;
+  }
+  else if (name == "silence") {
+    *type = SIGNAL_SILENCE;
+  }
+  else {
+    return false;
+  }
+  return true;
+}
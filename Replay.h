@@ -0,0 +1,45 @@
+#ifndef __REPLAY__h
+#define __REPLAY__h
+
+#include "Arduino.h"
+#include "GlobalDefines.h"
+#include "SensorData.h"
+#include "Statistics.h"
+#include "SigProc.h"
+#include "Watchdog.h"
+#include "Tools.h"
+
+#define REPLAY_MAX_SECONDS          60
+#define REPLAY_BLOCK_SIZE           256       // raw samples per decimator call, divides SAMPLE_RATE
+
+// Feeds synthetic ADC streams through the unmodified acquisition and signal processing path
+// (decimator -> ringbuffer -> SigProc::Calc -> Statistics::Calc) while the acquisition is stopped.
+// The result contains the processing throughput and a checksum over the integer results, so
+// the output of a firmware build can be compared against a reference before it is rolled out.
+class Replay {
+public:
+  enum SignalType {
+    SIGNAL_TONE,
+    SIGNAL_CHIRP,
+    SIGNAL_NOISE,
+    SIGNAL_BURST,         // chirp in the first half, silence afterwards (skipped by the energy gate)
+    SIGNAL_SILENCE
+  };
+
+  void Begin(SigProc *sigProc, Statistics *statistics, SensorData *sensorData, Watchdog *watchdog);
+  String Run(String params);
+
+private:
+  SigProc *m_sigProc;
+  Statistics *m_statistics;
+  SensorData *m_sensorData;
+  Watchdog *m_watchdog;
+  uint32_t m_noiseState;
+
+  uint16_t NextSample(SignalType type, uint32_t sampleNr, uint32_t nrOfSamples, float freq1, float freq2, uint16_t amplitude);
+  uint32_t Checksum();
+  float ZoomPeakFrequency();
+  static bool ParseSignalType(String name, SignalType *type);
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include "Rollup.h"
+
+// 15 min of 10 s records, 3 h of 1 min, 3 days of 1 h and a month of 1 day (approx. 33 kB)
+const uint32_t Rollup::m_seconds[ROLLUP_LEVELS] = { ROLLUP_BASE_SECONDS, 60, 3600, 86400 };
+const uint16_t Rollup::m_capacity[ROLLUP_LEVELS] = { 90, 180, 72, 31 };
+const char *Rollup::m_names[ROLLUP_LEVELS] = { "10s", "1m", "1h", "1d" };
+RollupRecord *Rollup::m_records[ROLLUP_LEVELS];
+uint16_t Rollup::m_next[ROLLUP_LEVELS];
+uint16_t Rollup::m_count[ROLLUP_LEVELS];
+Rollup::Accumulator Rollup::m_accumulator[ROLLUP_LEVELS];
+uint32_t Rollup::m_time = 0;
+SemaphoreHandle_t Rollup::m_mutex = NULL;
+
+// Allocates the records of all levels, once
+void Rollup::Begin() {
+  if (m_records[0]) {
+    return;
+  }
+
+  m_mutex = xSemaphoreCreateRecursiveMutex();
+  for (uint8_t level = 0; level < ROLLUP_LEVELS; level++) {
+    m_records[level] = new RollupRecord[m_capacity[level]];
+    m_next[level] = 0;
+    m_count[level] = 0;
+    memset(&m_accumulator[level], 0, sizeof(Accumulator));
+  }
+}
+
+bool Rollup::IsEnabled() {
+  return m_records[0] != NULL;
+}
+
+// seconds of processed signal since the start, the end of the last record
+uint32_t Rollup::GetTime() {
+  uint32_t time;
+
+  if (!IsEnabled()) {
+    return 0;
+  }
+
+  xSemaphoreTakeRecursive(m_mutex, portMAX_DELAY);
+  time = m_time;
+  xSemaphoreGiveRecursive(m_mutex);
+
+  return time;
+}
+
+// "10s", "1m", "1h" or "1d", -1 if unknown
+int8_t Rollup::GetLevel(String name) {
+  for (uint8_t level = 0; level < ROLLUP_LEVELS; level++) {
+    if (name == m_names[level]) {
+      return level;
+    }
+  }
+  return -1;
+}
+
+// Stores a record of the finest level (ROLLUP_BASE_SECONDS) and completes the coarser levels
+void Rollup::Add(RollupRecord *record) {
+  RollupRecord coarse;
+
+  if (!IsEnabled()) {
+    return;
+  }
+
+  xSemaphoreTakeRecursive(m_mutex, portMAX_DELAY);
+  m_time += ROLLUP_BASE_SECONDS;
+  record->time = m_time;
+  Store(0, record);
+
+  for (uint8_t level = 1; level < ROLLUP_LEVELS; level++) {
+    Accumulate(level, record);
+    if (m_accumulator[level].count < m_seconds[level] / m_seconds[level - 1]) {
+      break;
+    }
+    Downsample(level, &coarse);
+    Store(level, &coarse);
+    record = &coarse;
+  }
+  xSemaphoreGiveRecursive(m_mutex);
+}
+
+void Rollup::Store(uint8_t level, RollupRecord *record) {
+  m_records[level][m_next[level]] = *record;
+  m_next[level] = (m_next[level] + 1) % m_capacity[level];
+  if (m_count[level] < m_capacity[level]) {
+    m_count[level]++;
+  }
+}
+
+void Rollup::Accumulate(uint8_t level, RollupRecord *record) {
+  Accumulator *acc = &m_accumulator[level];
+  float weight = record->validWeight;
+
+  acc->validWeight += weight;
+  acc->preciAmount += record->preciAmount;
+  for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
+    acc->groupMagAVGkorr[binGroupNr] += record->groupMagAVGkorr[binGroupNr] * weight;
+  }
+  acc->domVotes[record->domGroupMagAboveThreshCnt] += weight;
+  acc->snapshots += record->snapshots;
+  acc->invalidSnapshots += record->invalidSnapshots;
+  acc->count++;
+}
+
+// Averages weighted by the valid time, the amount is summed like preciAmountAcc. The dominant group of the averages is the one with the highest
+// average, the dominant group of the counts is the one dominating most of the valid time.
+void Rollup::Downsample(uint8_t level, RollupRecord *record) {
+  Accumulator *acc = &m_accumulator[level];
+  float korr;
+  float maxKorr = 0;
+  float maxVotes = 0;
+
+  record->time = m_time;
+  record->validWeight = acc->validWeight;
+  record->preciAmount = acc->preciAmount;
+  record->snapshots = acc->snapshots;
+  record->invalidSnapshots = acc->invalidSnapshots;
+  record->domGroupMagAVGkorr = 0;
+  record->domGroupMagAboveThreshCnt = 0;
+
+  for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
+    korr = acc->validWeight > 0 ? acc->groupMagAVGkorr[binGroupNr] / acc->validWeight : 0;
+    record->groupMagAVGkorr[binGroupNr] = (uint16_t)(korr + 0.5f);
+    if (korr > maxKorr) {
+      maxKorr = korr;
+      record->domGroupMagAVGkorr = binGroupNr;
+    }
+    if (acc->domVotes[binGroupNr] > maxVotes) {
+      maxVotes = acc->domVotes[binGroupNr];
+      record->domGroupMagAboveThreshCnt = binGroupNr;
+    }
+  }
+
+  memset(acc, 0, sizeof(Accumulator));
+}
+
+String Rollup::FormatRecord(RollupRecord *record) {
+  String result;
+
+  result += String(record->time) + ",";
+  result += String(record->validWeight, 2) + ",";
+  result += String(record->preciAmount, 4) + ",";
+  result += String(record->domGroupMagAVGkorr) + ",";
+  result += String(record->domGroupMagAboveThreshCnt) + ",";
+  result += String(record->snapshots) + ",";
+  result += String(record->invalidSnapshots) + ",";
+  for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
+    result += String((float)record->groupMagAVGkorr[binGroupNr] / ROLLUP_KORR_SCALE, 2);
+    result += binGroupNr < NR_OF_BIN_GROUPS - 1 ? " " : "\n";
+  }
+
+  return result;
+}
+
+// Up to maxRecords records of a level with from <= time <= to as CSV lines (ROLLUP_HEADER), oldest
+// first. from is moved behind the last returned record, an empty result ends the query. The records
+// are selected by their time, so records added or overwritten between two calls are neither lost
+// nor repeated. The mutex is held for the whole chunk, Add() runs only every ROLLUP_BASE_SECONDS,
+// so the processing task waits at most for one chunk.
+String Rollup::GetChunk(uint8_t level, uint32_t &from, uint32_t to, uint16_t maxRecords) {
+  String result;
+  RollupRecord *record;
+  uint16_t nrOfRecords = 0;
+
+  if (!IsEnabled() || level >= ROLLUP_LEVELS) {
+    return result;
+  }
+
+  xSemaphoreTakeRecursive(m_mutex, portMAX_DELAY);
+  for (uint16_t i = 0; i < m_count[level] && nrOfRecords < maxRecords; i++) {
+    record = &m_records[level][(m_next[level] + m_capacity[level] - m_count[level] + i) % m_capacity[level]];
+
+    if (record->time < from) {
+      continue;
+    }
+    if (record->time > to) {
+      break;
+    }
+    result += FormatRecord(record);
+    from = record->time + 1;
+    nrOfRecords++;
+  }
+  xSemaphoreGiveRecursive(m_mutex);
+
+  return result;
+}
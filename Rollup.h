@@ -0,0 +1,70 @@
+#ifndef __ROLLUP__h
+#define __ROLLUP__h
+
+#include "Arduino.h"
+#include "GlobalDefines.h"
+
+#define ROLLUP_LEVELS              4
+#define ROLLUP_BASE_SECONDS        10         // time covered by a record of the finest level
+#define ROLLUP_KORR_SCALE          64         // group magAVGkorr in 1/64 steps, saturated at 1023.98
+#define ROLLUP_QUERY_CHUNK         16         // records per GetChunk() call
+#define ROLLUP_DATAPORT_RECORDS    32         // records per data port query, the next page starts after the last time
+#define ROLLUP_HEADER              "time,validWeight,preciAmount,domGroupMagAVGkorr,domGroupMagAboveThreshCnt,snapshots,invalidSnapshots,groupMagAVGkorr"
+
+// Record of one time slice. time: end of the slice in seconds of processed signal since the start,
+// the same clock as GetTime(). Averages are weighted by the valid time (validWeight) when downsampled,
+// counts and the precipitation amount are summed.
+struct RollupRecord {
+  uint32_t time;
+  float validWeight;                            // valid snapshots, weighted by the time they cover (50 % overlap = 1)
+  float preciAmount;                            // amount of the slice (its share of the interval amount), summed
+  uint32_t snapshots;
+  uint32_t invalidSnapshots;                    // clipping or ringbuffer overflow
+  uint16_t groupMagAVGkorr[NR_OF_BIN_GROUPS];   // ROLLUP_KORR_SCALE steps
+  uint8_t domGroupMagAVGkorr;
+  uint8_t domGroupMagAboveThreshCnt;
+};
+
+// On-device history of the statistics at several time resolutions (10 s, 1 min, 1 h, 1 day), fed
+// by Statistics::FinalizeSlice() every ROLLUP_BASE_SECONDS of signal. Each level is a circular buffer
+// of compact records, a level is downsampled from the finer one whenever its period is complete.
+// All records are allocated once by Begin(), nothing is allocated afterwards. Add() and the queries
+// may run on different cores, a mutex guards the buffers.
+class Rollup {
+public:
+  static void Begin();
+  static bool IsEnabled();
+  static void Add(RollupRecord *record);
+  static uint32_t GetTime();
+  static int8_t GetLevel(String name);
+  static String GetChunk(uint8_t level, uint32_t &from, uint32_t to, uint16_t maxRecords = ROLLUP_QUERY_CHUNK);
+
+private:
+  // downsampling of the records of the finer level, until the period of a level is complete
+  struct Accumulator {
+    float validWeight;
+    float preciAmount;
+    float groupMagAVGkorr[NR_OF_BIN_GROUPS];
+    float domVotes[NR_OF_BIN_GROUPS];           // domGroupMagAboveThreshCnt of the finer records, weighted
+    uint32_t snapshots;
+    uint32_t invalidSnapshots;
+    uint16_t count;
+  };
+
+  static const uint32_t m_seconds[ROLLUP_LEVELS];
+  static const uint16_t m_capacity[ROLLUP_LEVELS];
+  static const char *m_names[ROLLUP_LEVELS];
+  static RollupRecord *m_records[ROLLUP_LEVELS];
+  static uint16_t m_next[ROLLUP_LEVELS];
+  static uint16_t m_count[ROLLUP_LEVELS];
+  static Accumulator m_accumulator[ROLLUP_LEVELS];
+  static uint32_t m_time;
+  static SemaphoreHandle_t m_mutex;
+
+  static void Store(uint8_t level, RollupRecord *record);
+  static void Accumulate(uint8_t level, RollupRecord *record);
+  static void Downsample(uint8_t level, RollupRecord *record);
+  static String FormatRecord(RollupRecord *record);
+};
+
+#endif
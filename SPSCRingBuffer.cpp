@@ -0,0 +1,123 @@
+#include "SPSCRingBuffer.h"
+#include "GlobalDefines.h"
+#include "TimerSampleSource.h"
+
+// Only allowed while neither producer nor consumer are active
+template<typename T, uint32_t SIZE>
+void SPSCRingBuffer<T, SIZE>::Reset() {
+  __atomic_store_n(&m_in, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&m_out, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&m_dropped, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&m_highWater, 0, __ATOMIC_RELEASE);
+}
+
+// Returns the number of written samples, the remainder is dropped
+template<typename T, uint32_t SIZE>
+uint32_t SPSCRingBuffer<T, SIZE>::Write(const T *data, uint32_t count) {
+  uint32_t in = __atomic_load_n(&m_in, __ATOMIC_RELAXED);
+  uint32_t out = __atomic_load_n(&m_out, __ATOMIC_ACQUIRE);
+  uint32_t space = SIZE - (in - out);
+  uint32_t idx = in & (SIZE - 1);
+  uint32_t n;
+  uint32_t fill;
+
+  if (count > space) {
+    __atomic_fetch_add(&m_dropped, count - space, __ATOMIC_RELAXED);
+    count = space;
+  }
+
+  // up to two contiguous parts
+  n = SIZE - idx;
+  if (n > count) {
+    n = count;
+  }
+  memcpy(&m_data[idx], data, n * sizeof(T));
+  memcpy(&m_data[0], data + n, (count - n) * sizeof(T));
+
+  __atomic_store_n(&m_in, in + count, __ATOMIC_RELEASE);
+
+  fill = in + count - out;
+  if (fill > __atomic_load_n(&m_highWater, __ATOMIC_RELAXED)) {
+    __atomic_store_n(&m_highWater, fill, __ATOMIC_RELAXED);
+  }
+
+  return count;
+}
+
+template<typename T, uint32_t SIZE>
+uint32_t SPSCRingBuffer<T, SIZE>::Available() {
+  return __atomic_load_n(&m_in, __ATOMIC_ACQUIRE) - __atomic_load_n(&m_out, __ATOMIC_RELAXED);
+}
+
+// offset relative to the oldest unread sample, must be less than Available()
+template<typename T, uint32_t SIZE>
+T SPSCRingBuffer<T, SIZE>::Peek(uint32_t offset) {
+  return m_data[(__atomic_load_n(&m_out, __ATOMIC_RELAXED) + offset) & (SIZE - 1)];
+}
+
+// Direct access to the oldest count unread samples without consuming them: first[0 ... firstCount-1]
+// followed by second[0 ... secondCount-1] (secondCount is 0 if the data does not wrap around).
+// Returns firstCount + secondCount, less than count if not enough data is available.
+template<typename T, uint32_t SIZE>
+uint32_t SPSCRingBuffer<T, SIZE>::GetSegments(uint32_t count, const T **first, uint32_t *firstCount, const T **second, uint32_t *secondCount) {
+  uint32_t available = Available();
+  uint32_t idx = __atomic_load_n(&m_out, __ATOMIC_RELAXED) & (SIZE - 1);
+
+  if (count > available) {
+    count = available;
+  }
+
+  *first = &m_data[idx];
+  *firstCount = SIZE - idx;
+  if (*firstCount > count) {
+    *firstCount = count;
+  }
+  *second = &m_data[0];
+  *secondCount = count - *firstCount;
+
+  return count;
+}
+
+// Copies and consumes up to count samples, returns the number of samples read
+template<typename T, uint32_t SIZE>
+uint32_t SPSCRingBuffer<T, SIZE>::Read(T *data, uint32_t count) {
+  const T *first;
+  const T *second;
+  uint32_t firstCount;
+  uint32_t secondCount;
+
+  count = GetSegments(count, &first, &firstCount, &second, &secondCount);
+  memcpy(data, first, firstCount * sizeof(T));
+  memcpy(data + firstCount, second, secondCount * sizeof(T));
+  Consume(count);
+
+  return count;
+}
+
+// Releases count samples (at most Available()) to the producer
+template<typename T, uint32_t SIZE>
+void SPSCRingBuffer<T, SIZE>::Consume(uint32_t count) {
+  __atomic_store_n(&m_out, __atomic_load_n(&m_out, __ATOMIC_RELAXED) + count, __ATOMIC_RELEASE);
+}
+
+// Total number of dropped samples since Reset()
+template<typename T, uint32_t SIZE>
+uint32_t SPSCRingBuffer<T, SIZE>::GetDroppedCount() {
+  return __atomic_load_n(&m_dropped, __ATOMIC_RELAXED);
+}
+
+// Highest fill level since Reset() or the last TakeHighWater()
+template<typename T, uint32_t SIZE>
+uint32_t SPSCRingBuffer<T, SIZE>::GetHighWater() {
+  return __atomic_load_n(&m_highWater, __ATOMIC_RELAXED);
+}
+
+// Returns and restarts the high-water mark. A concurrent Write() may store its (higher or equal)
+// fill level afterwards, the result errs on the safe side.
+template<typename T, uint32_t SIZE>
+uint32_t SPSCRingBuffer<T, SIZE>::TakeHighWater() {
+  return __atomic_exchange_n(&m_highWater, 0, __ATOMIC_RELAXED);
+}
+
+template class SPSCRingBuffer<int16_t, RINGBUFFER_SIZE>;
+template class SPSCRingBuffer<uint16_t, TIMER_RAW_RB_SIZE>;
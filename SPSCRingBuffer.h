@@ -0,0 +1,58 @@
+#ifndef __SPSCRINGBUFFER__h
+#define __SPSCRINGBUFFER__h
+
+#include "Arduino.h"
+
+// Lock-free ringbuffer for exactly one producer and one consumer (ISR/task or task/task, also on
+// different cores). Each index is only written by one side. The producer publishes its write index
+// with release semantics after the data, the consumer acquires it before reading the data (and the
+// other way round for the read index), so no locks or critical sections are needed.
+// The indices run freely, SIZE must be a power of two. If the buffer is full the new samples are
+// dropped (the unread data is never overwritten) and counted.
+// Used at the ISR boundary of the timer sample source (raw samples, Put() in the ISR), where the
+// drop counter sees the real loss of the acquisition, and between the decimator and the FFT
+// (decimated samples, both sides in the processing task).
+template<typename T, uint32_t SIZE>
+class SPSCRingBuffer {
+public:
+  void Reset();
+
+  // producer
+  uint32_t Write(const T *data, uint32_t count);
+
+  // producer, a single element. Always inlined: a plain inline function may still be emitted out of
+  // line in flash, which an IRAM_ATTR interrupt handler must not call (flash cache off during NVS
+  // writes and OTA). The high-water mark is not updated.
+  inline __attribute__((always_inline)) bool Put(T value) {
+    uint32_t in = __atomic_load_n(&m_in, __ATOMIC_RELAXED);
+
+    if (in - __atomic_load_n(&m_out, __ATOMIC_ACQUIRE) >= SIZE) {
+      __atomic_store_n(&m_dropped, __atomic_load_n(&m_dropped, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+      return false;
+    }
+    m_data[in & (SIZE - 1)] = value;
+    __atomic_store_n(&m_in, in + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  // consumer
+  uint32_t Available();
+  T Peek(uint32_t offset);
+  uint32_t GetSegments(uint32_t count, const T **first, uint32_t *firstCount, const T **second, uint32_t *secondCount);
+  uint32_t Read(T *data, uint32_t count);
+  void Consume(uint32_t count);
+
+  // statistics
+  uint32_t GetDroppedCount();
+  uint32_t GetHighWater();
+  uint32_t TakeHighWater();
+
+private:
+  T m_data[SIZE];
+  uint32_t m_in;
+  uint32_t m_out;
+  uint32_t m_dropped;
+  uint32_t m_highWater;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef __SAMPLESOURCE__h
+#define __SAMPLESOURCE__h
+
+#include "Arduino.h"
+
+#define ISR_HISTOGRAM_BUCKETS        8        // < 64, < 128, ... < 4096, >= 4096 CPU cycles
+
+// Execution time of the sampling interrupt since the last TakeIsrStatistics()
+struct IsrStatistics {
+  uint32_t count;
+  uint32_t minCycles;
+  uint32_t avgCycles;
+  uint32_t maxCycles;
+  uint32_t histogram[ISR_HISTOGRAM_BUCKETS];
+};
+
+// Acquisition backend interface. A sample source delivers raw 12 bit ADC values at SAMPLE_RATE
+// to a block handler (the decimator). The handler is always called from Handle(), which is polled
+// in task context, never from an ISR.
+class SampleSource {
+public:
+  typedef void (*BlockHandler)(const uint16_t *block, uint16_t count);
+
+  virtual ~SampleSource() {}
+  virtual bool Begin(uint8_t adcPin, BlockHandler blockHandler) = 0;
+  virtual void Start() = 0;
+  virtual void Stop() = 0;
+  virtual void Handle() {}
+  virtual bool IsRunning() = 0;
+  virtual String Name() = 0;
+  virtual bool TakeIsrStatistics(IsrStatistics * /*stats*/) { return false; }
+
+  // raw samples lost by the acquisition itself (DMA or ISR buffer overrun) since Start()
+  virtual uint32_t GetDroppedCount() { return 0; }
+};
+
+#endif
@@ -1,7 +1,78 @@
 #include "SensorData.h"
 
+// The hot fields first, every array starts at a multiple of FFT_BINS_ALIGN bytes
+void FFT_BINS::Allocate(uint nrOfBins) {
+  uint32_t padded = (nrOfBins + (FFT_BINS_ALIGN / sizeof(uint16_t)) - 1) & ~((FFT_BINS_ALIGN / sizeof(uint16_t)) - 1);
+
+  delete[] m_block;
+  m_blockSize = (padded * (2 * sizeof(uint16_t) + sizeof(uint64_t) + 2 * sizeof(float))) / sizeof(uint32_t);
+  m_block = new uint32_t[m_blockSize]();
+
+  mag = (uint16_t *)m_block;
+  magMax = mag + padded;
+  magSum = (uint64_t *)(magMax + padded);
+  magAVG = (float *)(magSum + padded);
+  magAVGkorr = magAVG + padded;
+}
+
+FFT_BINS::~FFT_BINS() {
+  delete[] m_block;
+}
+
+bool FFT_BINS::IsAllocated() const {
+  return m_block != NULL;
+}
+
+// Copies the values, nothing if one of both is not allocated. Both must have the same size.
+FFT_BINS &FFT_BINS::operator=(const FFT_BINS &other) {
+  if (m_block && other.m_block && (this != &other)) {
+    memcpy(m_block, other.m_block, m_blockSize * sizeof(uint32_t));
+  }
+  return *this;
+}
+
 SensorData::SensorData(uint nrOfBins, byte nrOfBinGroups) {
-  bin = new FFT_BIN[nrOfBins];
-  binGroup = new FFT_BIN_GROUP[nrOfBinGroups];
+  m_nrOfBins = nrOfBins;
+  m_nrOfBinGroups = nrOfBinGroups;
+  // nrOfBins 0: groups only
+  if (nrOfBins > 0) {
+    bin.Allocate(nrOfBins);
+  }
+  binGroup = new FFT_BIN_GROUP[nrOfBinGroups]();
+}
+
+SensorData::~SensorData() {
+  delete[] binGroup;
+  delete[] zoomBinGroup;
+}
+
+// Copies all values without any allocation, both objects must have the same dimensions.
+// The bins are copied by FFT_BINS::operator=, the zoom bins only if both objects have them.
+void SensorData::CopyFrom(const SensorData *other) {
+  FFT_BIN_GROUP *ownBinGroup = binGroup;
+  FFT_BIN_GROUP *ownZoomBinGroup = zoomBinGroup;
+  uint nrOfZoomBins = m_nrOfZoomBins;
+  byte nrOfZoomBinGroups = m_nrOfZoomBinGroups;
+
+  *this = *other;
+  binGroup = ownBinGroup;
+  zoomBinGroup = ownZoomBinGroup;
+  m_nrOfZoomBins = nrOfZoomBins;
+  m_nrOfZoomBinGroups = nrOfZoomBinGroups;
+
+  memcpy(binGroup, other->binGroup, m_nrOfBinGroups * sizeof(FFT_BIN_GROUP));
+  if (zoomBinGroup && other->zoomBinGroup) {
+    memcpy(zoomBinGroup, other->zoomBinGroup, m_nrOfZoomBinGroups * sizeof(FFT_BIN_GROUP));
+  }
+}
+
+// Bins and groups of the zoom FFT, only allocated if the zoom FFT is enabled
+void SensorData::AllocateZoom(uint nrOfZoomBins, byte nrOfZoomBinGroups) {
+  if (zoomBinGroup) {
+    return;
+  }
+  m_nrOfZoomBins = nrOfZoomBins;
+  m_nrOfZoomBinGroups = nrOfZoomBinGroups;
+  zoomBin.Allocate(nrOfZoomBins);
+  zoomBinGroup = new FFT_BIN_GROUP[nrOfZoomBinGroups]();
 }
-
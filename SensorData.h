@@ -3,17 +3,34 @@
 
 #include "Arduino.h"
 
-struct FFT_BIN {
-  uint16_t mag;
-  uint16_t magMax;
-  float magSum;
-  float magAVG;
-  float magAVGkorr;
+// Bin data as one array per field (structure of arrays). The snapshot loops of Statistics run over
+// the dense mag, magMax and magSum arrays only, the averages of Finalize() are kept apart.
+// The arrays share one allocation, each one padded to FFT_BINS_ALIGN bytes.
+#define FFT_BINS_ALIGN    16
+
+class FFT_BINS {
+public:
+  uint16_t *mag = NULL;
+  uint16_t *magMax = NULL;
+  uint64_t *magSum = NULL;           // hop weighted (zoom: plain) sum of the magnitudes
+  float *magAVG = NULL;
+  float *magAVGkorr = NULL;
+
+  FFT_BINS() {}
+  FFT_BINS(const FFT_BINS &) = delete;
+  ~FFT_BINS();
+  FFT_BINS &operator=(const FFT_BINS &other);
+  void Allocate(uint nrOfBins);
+  bool IsAllocated() const;
+
+private:
+  uint32_t *m_block = NULL;
+  uint32_t m_blockSize = 0;           // 32 bit words
 };
 
 struct FFT_BIN_GROUP {
-  uint8_t firstBin;  
-  uint8_t lastBin;
+  uint16_t firstBin;
+  uint16_t lastBin;
   uint16_t magMax;
   float magAVG;
   uint16_t magThresh;
@@ -24,21 +41,36 @@ struct FFT_BIN_GROUP {
   float magAVGkorrDom;
   float magAVGkorrDom2;
   float preciAmountFactor;
+  uint16_t magQ50;                  // quantiles of the maximum of the group bins per snapshot
+  uint16_t magQ95;
+  uint16_t magQ99;
 };
 
 class SensorData {
 public:
   FFT_BIN_GROUP *binGroup = NULL;
-  FFT_BIN *bin = NULL;
+  FFT_BINS bin;
+  FFT_BIN_GROUP *zoomBinGroup = NULL;    // zoom FFT only
+  FFT_BINS zoomBin;
 
   int16_t ADCoffset;
   float magAVG;
   float magAVGkorr;
   uint16_t magMax;
   uint32_t RbOvCtr;
+  uint32_t RbDroppedSamples;
+  uint32_t RbHighWater;
   uint16_t ADCpeakSample;
   uint32_t snapshotCtr;
   uint32_t snapshotValidCtr;
+  float snapshotValidWeight;          // valid snapshots, weighted by the time they cover (50 % overlap = 1), set by Finalize()
+  uint32_t hopWidenedCtr;
+  uint32_t gatedSnapshotCtr;          // valid snapshots skipped by the energy gate
+  uint16_t sdftMaxDeviation;          // sliding DFT against FFT magnitude ("both" spectrum mode)
+  float humSuppression;               // signal power removed by the hum canceller (dB)
+  uint16_t humAmplitude;              // estimated hum amplitude (ADC steps)
+  uint8_t zoomFactor;
+  uint32_t zoomSnapshotCtr;
   uint16_t clippingCtr;
   uint8_t DomGroupMagAVGkorr;
   uint8_t DomGroupMagAboveThreshCnt;
@@ -46,9 +78,16 @@ public:
   float preciAmountAcc;
 
   SensorData(uint nrOfBins, byte nrOfBinGroups);
+  ~SensorData();
+  void CopyFrom(const SensorData *other);
+  void AllocateZoom(uint nrOfZoomBins, byte nrOfZoomBinGroups);
 
 private:
+  uint m_nrOfBins;
+  byte m_nrOfBinGroups;
+  uint m_nrOfZoomBins = 0;
+  byte m_nrOfZoomBinGroups = 0;
 
 };
 
-#endif
+#endif
@@ -7,39 +7,104 @@
 #include "SensorData.h"
 #include "Statistics.h"
 #include "Publisher.h"
+#include "Magnitude.h"
+#include "FFTEngine.h"
+#include "SampleSource.h"
+#include "Profiler.h"
+#include "TimerSampleSource.h"
+#include "I2SSampleSource.h"
+#include "Decimator.h"
+#include "SPSCRingBuffer.h"
+#include "SlidingDFT.h"
+#include "HumCanceller.h"
+#include "ZoomFFT.h"
+
+#define SIGPROC_TASK_STACK_SIZE    (8192 + (NR_OF_FFT_SAMPLES << 3))     // FFT work buffers are on the stack
+#define SIGPROC_TASK_PRIORITY      5
+#define SIGPROC_TASK_CORE          0                                     // loop() runs on core 1
+#define SDFT_DEFAULT_HOP           128                                   // 6.25 ms snapshot interval in sliding DFT mode
+#define GATE_MARGIN                4                                     // FFT rounding and DC removal error of the magnitude bound
 
 class SigProc {
+  friend class Benchmark;
+  friend class AccuracyTest;
+
 public:
   void Begin(Settings *settings, SensorData *sensorData, Statistics *statistics, Publisher *publisher);
   void Handle();
   void StartCapture();
   void StopCapture();
-  void Calc();
+  bool Calc();
   bool IsCapturing();
+  void ProcessSnapshot();
+  void ResetCapture();
+  void TakeHumStatistics();
+  uint8_t SnapPending();
+  bool SetSampleSource(SampleSource *sampleSource);
+  String GetSampleSourceName();
+  bool TakeIsrStatistics(IsrStatistics *stats);
+  void Lock();
+  void Unlock();
+  bool IsPipelined();
+  float GetTaskLoad();
+  uint32_t GetTaskStackFree();
+  uint32_t GetPublishDropCount();
+  static void AddRawBlock(const uint16_t *block, uint16_t count);
 
 private:
   Settings *m_settings;
   SensorData *m_sensorData;
   Statistics *m_statistics;  
   Publisher *m_publisher;
-  hw_timer_t *timer = NULL;
-  static volatile int16_t sampleRb[RINGBUFFER_SIZE];
-  static volatile uint32_t samplePtrIn;
-  static volatile uint32_t samplePtrOut;
-  static volatile uint32_t RbOvFlag;
-  static volatile byte m_adcPin;
+  SampleSource *m_sampleSource = NULL;
+  TimerSampleSource m_timerSource;
+  I2SSampleSource m_i2sSource;
+  static SPSCRingBuffer<int16_t, RINGBUFFER_SIZE> m_sampleRb;
+  uint32_t m_lastDroppedCount;         // GetDroppedSamples() at the last snapshot
+  static Decimator m_decimator;
+  static HumCanceller m_humCanceller;
+  uint8_t m_adcPin;
   uint publishInterval;
   bool m_isCapturing;
+  bool m_realFFT;
+  Magnitude::Mode m_magMode;
+  uint16_t m_hop;                       // configured snapshot distance in samples (overlap)
+  uint16_t m_currentHop;                // distance to the next snapshot, widened under backlog
+  bool m_adaptiveHop;
+  uint32_t m_intervalSamples;           // time covered by the current publish interval
+  uint32_t m_sliceSamples;              // time covered by the current rollup slice
+  uint32_t m_sliceSnapshots;
+  bool m_energyGate;                    // skip the FFT of near-silent snapshots, see Statistics::GetGateBound()
+  SlidingDFT::Mode m_sdftMode;
+  SlidingDFT m_sdft;
+  ZoomFFT m_zoom;
+  uint16_t m_newSamples;                // newest samples of the snapshot not yet fed into sliding DFT and zoom FFT
+  FFTEngine<NR_OF_FFT_SAMPLES_bit> m_fft;
 
-  static void IRAM_ATTR onTimer();
-  uint8_t SnapPending();
-  inline int16_t MAS(int16_t a, int16_t b);
-  void Window(int16_t *re, uint8_t m, int16_t *windowTable);
-  void FFT(int16_t *fr, int16_t *fi, uint16_t m);
+  // pipelined mode: processing task on SIGPROC_TASK_CORE, results are handed over to loop()
+  bool m_isPipelined;
+  TaskHandle_t m_taskHandle = NULL;
+  SemaphoreHandle_t m_mutex = NULL;
+  SensorData *m_publishData;
+  uint8_t m_publishPending;
+  uint32_t m_publishDropCount;
+  float m_taskLoad;
+
+  static void TaskEntry(void *param);
+  void Task();
+  bool Process();
+  uint16_t NextHop();
+  uint32_t GetDroppedSamples();
+  void ProcessNewSamples();
+  void CompareSlidingDFT();
+  void AddZoomSamples(uint32_t from, uint32_t to);
+  void CalcZoom();
+  uint16_t Preprocess(int16_t *re, int16_t *im);
+  void CalcSpectrum(int16_t *re, int16_t *im);
   
   void DebugConsoleOutBins(uint16_t startIdx, uint16_t stopIdx);
   void DebugConsoleOutSamples(uint16_t startIdx, uint16_t stopIdx);
 };
 
 
-#endif
+#endif
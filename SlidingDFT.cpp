@@ -0,0 +1,108 @@
+#include "SlidingDFT.h"
+
+SlidingDFT::~SlidingDFT() {
+  delete[] m_re;
+  delete[] m_im;
+  delete[] m_cos;
+  delete[] m_sin;
+  delete[] m_delay;
+}
+
+// Bins firstBin ... lastBin, limited to 2 ... NR_OF_BINS - 1
+void SlidingDFT::Begin(uint16_t firstBin, uint16_t lastBin) {
+  m_firstBin = firstBin < 2 ? 2 : firstBin;
+  m_lastBin = lastBin > NR_OF_BINS - 1 ? NR_OF_BINS - 1 : lastBin;
+  if (m_lastBin < m_firstBin) {
+    m_lastBin = m_firstBin;
+  }
+  m_nrOfBins = m_lastBin - m_firstBin + 3;
+
+  delete[] m_re;
+  delete[] m_im;
+  delete[] m_cos;
+  delete[] m_sin;
+  delete[] m_delay;
+  m_re = new float[m_nrOfBins];
+  m_im = new float[m_nrOfBins];
+  m_cos = new float[m_nrOfBins];
+  m_sin = new float[m_nrOfBins];
+  m_delay = new int16_t[NR_OF_FFT_SAMPLES];
+
+  for (uint16_t k = 0; k < m_nrOfBins; k++) {
+    m_cos[k] = SDFT_DAMPING * cosf(2 * PI * (m_firstBin - 1 + k) / NR_OF_FFT_SAMPLES);
+    m_sin[k] = SDFT_DAMPING * sinf(2 * PI * (m_firstBin - 1 + k) / NR_OF_FFT_SAMPLES);
+  }
+  m_dampingN = powf(SDFT_DAMPING, NR_OF_FFT_SAMPLES);
+
+  Reset();
+}
+
+void SlidingDFT::Reset() {
+  memset(m_re, 0, m_nrOfBins * sizeof(float));
+  memset(m_im, 0, m_nrOfBins * sizeof(float));
+  memset(m_delay, 0, NR_OF_FFT_SAMPLES * sizeof(int16_t));
+  m_delayPos = 0;
+  m_sampleSum = 0;
+}
+
+// S_k(n) = r * e^(j*2*pi*k/N) * (S_k(n-1) + x(n) - r^N * x(n-N))
+// The samples are processed in blocks, so the state of a bin stays in registers for a whole block.
+void SlidingDFT::Update(const int16_t *samples, uint16_t count) {
+  float delta[SDFT_BLOCK_SIZE];
+  uint16_t blockSize;
+  int16_t oldSample;
+  float re, im, c, s, tmp;
+
+  while (count > 0) {
+    blockSize = count > SDFT_BLOCK_SIZE ? SDFT_BLOCK_SIZE : count;
+
+    for (uint16_t i = 0; i < blockSize; i++) {
+      oldSample = m_delay[m_delayPos];
+      m_delay[m_delayPos] = samples[i];
+      m_delayPos = (m_delayPos + 1) & (NR_OF_FFT_SAMPLES - 1);
+      m_sampleSum += samples[i] - oldSample;
+      delta[i] = samples[i] - m_dampingN * oldSample;
+    }
+
+    for (uint16_t k = 0; k < m_nrOfBins; k++) {
+      re = m_re[k];
+      im = m_im[k];
+      c = m_cos[k];
+      s = m_sin[k];
+      for (uint16_t i = 0; i < blockSize; i++) {
+        re += delta[i];
+        tmp = re * c - im * s;
+        im = re * s + im * c;
+        re = tmp;
+      }
+      m_re[k] = re;
+      m_im[k] = im;
+    }
+
+    samples += blockSize;
+    count -= blockSize;
+  }
+}
+
+// Hann windowed magnitude, scaled like the FFT magnitude of SigProc (input << 4, 1/N)
+uint16_t SlidingDFT::Magnitude(uint16_t binNr) {
+  uint16_t k = binNr - m_firstBin + 1;
+  float re = 0.5f * m_re[k] - 0.25f * (m_re[k - 1] + m_re[k + 1]);
+  float im = 0.5f * m_im[k] - 0.25f * (m_im[k - 1] + m_im[k + 1]);
+  float mag = sqrtf(re * re + im * im) * (16.0f / NR_OF_FFT_SAMPLES);
+
+  return mag < 65535.0f ? (uint16_t)mag : 65535;
+}
+
+uint16_t SlidingDFT::GetFirstBin() {
+  return m_firstBin;
+}
+
+uint16_t SlidingDFT::GetLastBin() {
+  return m_lastBin;
+}
+
+// sum of the samples in the window, e.g. for the ADC offset
+int32_t SlidingDFT::GetSampleSum() {
+  return m_sampleSum;
+}
@@ -0,0 +1,54 @@
+#ifndef __SLIDINGDFT__h
+#define __SLIDINGDFT__h
+
+#include "Arduino.h"
+#include "GlobalDefines.h"
+
+#define SDFT_DAMPING               0.99999f   // keeps the recursion stable despite float rounding (r^N = 0.99 for N = 1024)
+#define SDFT_BLOCK_SIZE            64         // samples per pass over the bins
+
+// Sliding DFT over the last NR_OF_FFT_SAMPLES samples for a contiguous range of bins, updated sample
+// by sample. The Hann window is applied in the frequency domain (3 tap kernel on the neighbouring
+// bins), so the magnitudes are scaled like the ones of the windowed fixed point FFT and the ADC
+// offset does not leak into bins >= 2.
+// Cost per sample and selected bin: one complex multiplication, i.e. only a few bins are cheaper
+// than the full FFT.
+class SlidingDFT {
+public:
+  enum Mode {
+    MODE_FFT,       // FFT only
+    MODE_BOTH,      // FFT for all bins, sliding DFT beside it for comparison
+    MODE_SDFT       // sliding DFT only, selected bins on a finer time grid
+  };
+
+  static Mode ModeFromString(String mode) {
+    if (mode == "sdft") {
+      return MODE_SDFT;
+    }
+    return mode == "both" ? MODE_BOTH : MODE_FFT;
+  }
+
+  ~SlidingDFT();
+  void Begin(uint16_t firstBin, uint16_t lastBin);
+  void Reset();
+  void Update(const int16_t *samples, uint16_t count);
+  uint16_t Magnitude(uint16_t binNr);
+  uint16_t GetFirstBin();
+  uint16_t GetLastBin();
+  int32_t GetSampleSum();
+
+private:
+  uint16_t m_firstBin;
+  uint16_t m_lastBin;
+  uint16_t m_nrOfBins;                  // selected bins plus one neighbour on each side
+  float *m_re = NULL;
+  float *m_im = NULL;
+  float *m_cos = NULL;                  // damped twiddle factors r * e^(j*2*pi*k/N)
+  float *m_sin = NULL;
+  float m_dampingN;                     // r^N, applied to the sample leaving the window
+  int16_t *m_delay = NULL;              // the last NR_OF_FFT_SAMPLES samples
+  uint16_t m_delayPos;
+  int32_t m_sampleSum;
+};
+
+#endif
@@ -99,6 +99,21 @@ void StateManager::Update() {
   m_values.Put("LD.Avg (ms)", String((float)m_loopDurationAvg / 1000.0));
   m_values.Put("LD.Max (ms)", String((float)m_loopDurationMax / 1000.0));
 
+  for (uint i = 0; i < m_externalValues.Size(); i++) {
+    m_values.Put(m_externalValues.GetKeyAt(i), m_externalValues.GetValueAt(i));
+  }
+}
+
+// Values provided by other modules, shown with the internal ones
+void StateManager::SetValue(String key, String value) {
+  String *existing = m_externalValues.GetPointer(key);
+
+  if (existing) {
+    *existing = value;
+  }
+  else if (m_externalValues.Size() < m_externalValues.GetCapacity()) {
+    m_externalValues.Put(key, value);
+  }
 }
 
 String StateManager::GetHTML() {
@@ -23,6 +23,7 @@ private:
    
   uint32_t m_loopDurationMin, m_loopDurationAvg, m_loopDurationMax;
   HashMap<String, String, 20> m_values;
+  HashMap<String, String, 8> m_externalValues;
   bool m_roolOverIsPossible = false;
   unsigned int m_uptimeDays = 0;
 
@@ -42,6 +43,7 @@ public:
   void SetWiFiConnectTime(float connectTime);
   float GetWiFiConnectTime();
   void Update();
+  void SetValue(String key, String value);
 
 };
 
@@ -1,237 +1,622 @@
 #include "Statistics.h"
 
 /* The following table holds the number of snapshots (a 25ms) that the "same" drop is
- * visible to the radar sensor, based on an average 1m FOV with a 0° sensor tilt
+ * visible to the radar sensor, based on an average 1m FOV with a 0° sensor tilt.
+ * The visible time is inversely proportional to the doppler frequency, the product of
+ * bin resolution and snapshot interval is 1/2 for every FFT size, so the table
+ * only depends on the bin number: 322.6667 / binNr (bin 0: 1).
+ * (DROP_IN_FOV_TIME_FREQ, see Statistics.h)
  */
-const float dropInFOVsnapshots[NR_OF_BINS] = {
-  1.0000, 322.6667, 161.3333, 107.5556, 80.6667, 64.5333, 53.7778, 46.0952,
-  40.3333, 35.8519, 32.2667, 29.3333, 26.8889, 24.8205, 23.0476, 21.5111,
-  20.1667, 18.9804, 17.9259, 16.9825, 16.1333, 15.3651, 14.6667, 14.0290,
-  13.4444, 12.9067, 12.4103, 11.9506, 11.5238, 11.1264, 10.7556, 10.4086,
-  10.0833, 9.7778, 9.4902, 9.2190, 8.9630, 8.7207, 8.4912, 8.2735,
-  8.0667, 7.8699, 7.6825, 7.5039, 7.3333, 7.1704, 7.0145, 6.8652,
-  6.7222, 6.5850, 6.4533, 6.3268, 6.2051, 6.0881, 5.9753, 5.8667,
-  5.7619, 5.6608, 5.5632, 5.4689, 5.3778, 5.2896, 5.2043, 5.1217,
-  5.0417, 4.9641, 4.8889, 4.8159, 4.7451, 4.6763, 4.6095, 4.5446,
-  4.4815, 4.4201, 4.3604, 4.3022, 4.2456, 4.1905, 4.1368, 4.0844,
-  4.0333, 3.9835, 3.9350, 3.8876, 3.8413, 3.7961, 3.7519, 3.7088,
-  3.6667, 3.6255, 3.5852, 3.5458, 3.5072, 3.4695, 3.4326, 3.3965,
-  3.3611, 3.3265, 3.2925, 3.2593, 3.2267, 3.1947, 3.1634, 3.1327,
-  3.1026, 3.0730, 3.0440, 3.0156, 2.9877, 2.9602, 2.9333, 2.9069,
-  2.8810, 2.8555, 2.8304, 2.8058, 2.7816, 2.7578, 2.7345, 2.7115,
-  2.6889, 2.6667, 2.6448, 2.6233, 2.6022, 2.5813, 2.5608, 2.5407,
-  2.5208, 2.5013, 2.4821, 2.4631, 2.4444, 2.4261, 2.4080, 2.3901,
-  2.3725, 2.3552, 2.3382, 2.3213, 2.3048, 2.2884, 2.2723, 2.2564,
-  2.2407, 2.2253, 2.2100, 2.1950, 2.1802, 2.1655, 2.1511, 2.1369,
-  2.1228, 2.1089, 2.0952, 2.0817, 2.0684, 2.0552, 2.0422, 2.0294,
-  2.0167, 2.0041, 1.9918, 1.9796, 1.9675, 1.9556, 1.9438, 1.9321,
-  1.9206, 1.9093, 1.8980, 1.8869, 1.8760, 1.8651, 1.8544, 1.8438,
-  1.8333, 1.8230, 1.8127, 1.8026, 1.7926, 1.7827, 1.7729, 1.7632,
-  1.7536, 1.7441, 1.7348, 1.7255, 1.7163, 1.7072, 1.6982, 1.6894,
-  1.6806, 1.6718, 1.6632, 1.6547, 1.6463, 1.6379, 1.6296, 1.6214,
-  1.6133, 1.6053, 1.5974, 1.5895, 1.5817, 1.5740, 1.5663, 1.5588,
-  1.5513, 1.5439, 1.5365, 1.5292, 1.5220, 1.5149, 1.5078, 1.5008,
-  1.4938, 1.4869, 1.4801, 1.4734, 1.4667, 1.4600, 1.4535, 1.4469,
-  1.4405, 1.4341, 1.4277, 1.4214, 1.4152, 1.4090, 1.4029, 1.3968,
-  1.3908, 1.3848, 1.3789, 1.3730, 1.3672, 1.3615, 1.3557, 1.3501,
-  1.3444, 1.3389, 1.3333, 1.3278, 1.3224, 1.3170, 1.3117, 1.3063,
-  1.3011, 1.2959, 1.2907, 1.2855, 1.2804, 1.2754, 1.2703, 1.2654,
-  1.2604, 1.2555, 1.2506, 1.2458, 1.2410, 1.2363, 1.2316, 1.2269,
-  1.2222, 1.2176, 1.2130, 1.2085, 1.2040, 1.1995, 1.1951, 1.1907,
-  1.1863, 1.1819, 1.1776, 1.1733, 1.1691, 1.1649, 1.1607, 1.1565,
-  1.1524, 1.1483, 1.1442, 1.1402, 1.1362, 1.1322, 1.1282, 1.1243,
-  1.1204, 1.1165, 1.1126, 1.1088, 1.1050, 1.1013, 1.0975, 1.0938,
-  1.0901, 1.0864, 1.0828, 1.0792, 1.0756, 1.0720, 1.0684, 1.0649,
-  1.0614, 1.0579, 1.0545, 1.0510, 1.0476, 1.0442, 1.0409, 1.0375,
-  1.0342, 1.0309, 1.0276, 1.0243, 1.0211, 1.0179, 1.0147, 1.0115,
-  1.0083, 1.0052, 1.0021, 0.9990, 0.9959, 0.9928, 0.9898, 0.9867,
-  0.9837, 0.9807, 0.9778, 0.9748, 0.9719, 0.9690, 0.9661, 0.9632,
-  0.9603, 0.9575, 0.9546, 0.9518, 0.9490, 0.9462, 0.9435, 0.9407,
-  0.9380, 0.9353, 0.9326, 0.9299, 0.9272, 0.9245, 0.9219, 0.9193,
-  0.9167, 0.9141, 0.9115, 0.9089, 0.9064, 0.9038, 0.9013, 0.8988,
-  0.8963, 0.8938, 0.8913, 0.8889, 0.8864, 0.8840, 0.8816, 0.8792,
-  0.8768, 0.8744, 0.8721, 0.8697, 0.8674, 0.8651, 0.8627, 0.8604,
-  0.8582, 0.8559, 0.8536, 0.8514, 0.8491, 0.8469, 0.8447, 0.8425,
-  0.8403, 0.8381, 0.8359, 0.8338, 0.8316, 0.8295, 0.8274, 0.8252,
-  0.8231, 0.8210, 0.8190, 0.8169, 0.8148, 0.8128, 0.8107, 0.8087,
-  0.8067, 0.8047, 0.8027, 0.8007, 0.7987, 0.7967, 0.7947, 0.7928,
-  0.7908, 0.7889, 0.7870, 0.7851, 0.7832, 0.7813, 0.7794, 0.7775,
-  0.7756, 0.7738, 0.7719, 0.7701, 0.7683, 0.7664, 0.7646, 0.7628,
-  0.7610, 0.7592, 0.7574, 0.7557, 0.7539, 0.7521, 0.7504, 0.7486,
-  0.7469, 0.7452, 0.7435, 0.7418, 0.7401, 0.7384, 0.7367, 0.7350,
-  0.7333, 0.7317, 0.7300, 0.7284, 0.7267, 0.7251, 0.7235, 0.7218,
-  0.7202, 0.7186, 0.7170, 0.7154, 0.7139, 0.7123, 0.7107, 0.7092,
-  0.7076, 0.7061, 0.7045, 0.7030, 0.7014, 0.6999, 0.6984, 0.6969,
-  0.6954, 0.6939, 0.6924, 0.6909, 0.6895, 0.6880, 0.6865, 0.6851,
-  0.6836, 0.6822, 0.6807, 0.6793, 0.6779, 0.6765, 0.6750, 0.6736,
-  0.6722, 0.6708, 0.6694, 0.6680, 0.6667, 0.6653, 0.6639, 0.6626,
-  0.6612, 0.6599, 0.6585, 0.6572, 0.6558, 0.6545, 0.6532, 0.6519,
-  0.6505, 0.6492, 0.6479, 0.6466, 0.6453, 0.6440, 0.6428, 0.6415,
-  0.6402, 0.6389, 0.6377, 0.6364, 0.6352, 0.6339, 0.6327, 0.6314
-};
+
+static float dropInFOVsnapshots[NR_OF_BINS];
+static uint32_t aboveThreshWeight[NR_OF_BINS];    // 1 / dropInFOVsnapshots, Q20 (STAT_RECIPROCAL_bit)
 
 void Statistics::Begin(Settings *settings, SensorData *sensorData) {
   m_settings = settings;
   m_sensorData = sensorData;
   thresholdOffset = m_settings->GetFloat("ThresholdOffset", DEFAULT_THRESHOLD_OFFSET);
   countThreshold = m_settings->GetFloat("CountThreshold", DEFAULT_COUNT_THRESHOLD);
+  uint publishInterval = m_settings->GetUInt("PublishInterval", DEFAULT_PUBLISH_INTERVAL);
+  m_sliceAmountScale = publishInterval > 0 ? (float)ROLLUP_BASE_SECONDS / publishInterval : 0;
+
+  dropInFOVsnapshots[0] = 1.0;
+  for (uint16_t binNr = 1; binNr < NR_OF_BINS; binNr++) {
+    dropInFOVsnapshots[binNr] = DROP_IN_FOV_TIME_FREQ / (binNr * BIN_RESOLUTION * ((float)(NR_OF_FFT_SAMPLES >> 1) / (SAMPLE_RATE >> 1)));
+  }
+  for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+    aboveThreshWeight[binNr] = (uint32_t)((1UL << STAT_RECIPROCAL_bit) / dropInFOVsnapshots[binNr] + 0.5f);
+  }
+
+  SetBinGroups();
+  ResetSlice();
   Reset();
 }
 
-void Statistics::Calibrate() {
-  // store current magMax values as calibration reference
+// Bin -> group table from the group boundaries (BG<n>T). The optional setting BG<n>R replaces the
+// boundaries of group n by a list of bins and bin ranges, e.g. "40-60,72,80-95", so groups may
+// have gaps or overlap. Bins of several groups are counted with the threshold of the lowest one.
+// To be called whenever the group definitions change.
+void Statistics::SetBinGroups() {
+  String ranges;
+  String range;
+  int start;
+  int end;
+  int dash;
+
+  memset(m_binGroups, 0, sizeof(m_binGroups));
+  memset(m_nrOfBinsInGroup, 0, sizeof(m_nrOfBinsInGroup));
+
+  for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
+    ranges = m_settings->Get("BG" + String(binGroupNr) + "R", "");
+    if (ranges.length() == 0) {
+      AddBinRange(binGroupNr, m_sensorData->binGroup[binGroupNr].firstBin, m_sensorData->binGroup[binGroupNr].lastBin);
+      continue;
+    }
+
+    // firstBin and lastBin become the span of the ranges
+    m_sensorData->binGroup[binGroupNr].firstBin = NR_OF_BINS - 1;
+    m_sensorData->binGroup[binGroupNr].lastBin = 1;
+    start = 0;
+    while (start < (int)ranges.length()) {
+      end = ranges.indexOf(',', start);
+      if (end < 0) {
+        end = ranges.length();
+      }
+      range = ranges.substring(start, end);
+      dash = range.indexOf('-');
+      if (dash < 0) {
+        AddBinRange(binGroupNr, range.toInt(), range.toInt());
+      } else {
+        AddBinRange(binGroupNr, range.substring(0, dash).toInt(), range.substring(dash + 1).toInt());
+      }
+      start = end + 1;
+    }
+  }
+
+  m_ownerGroups = 0;
+  for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+    m_binOwner[binNr] = m_binGroups[binNr] ? __builtin_ctz(m_binGroups[binNr]) : NR_OF_BIN_GROUPS;
+    m_ownerGroups |= m_binGroups[binNr] & -m_binGroups[binNr];
+  }
+
+  ScaleThresholds();
+}
+
+// bins from ... to of a group, limited to 1 ... NR_OF_BINS - 1
+void Statistics::AddBinRange(uint8_t binGroupNr, long from, long to) {
+  if (from < 1) {
+    from = 1;
+  }
+  if (to > NR_OF_BINS - 1) {
+    to = NR_OF_BINS - 1;
+  }
+  if (from > to) {
+    return;
+  }
+
+  for (long binNr = from; binNr <= to; binNr++) {
+    if (!(m_binGroups[binNr] & (1UL << binGroupNr))) {
+      m_binGroups[binNr] |= 1UL << binGroupNr;
+      m_nrOfBinsInGroup[binGroupNr]++;
+    }
+  }
+  if (from < m_sensorData->binGroup[binGroupNr].firstBin) {
+    m_sensorData->binGroup[binGroupNr].firstBin = from;
+  }
+  if (to > m_sensorData->binGroup[binGroupNr].lastBin) {
+    m_sensorData->binGroup[binGroupNr].lastBin = to;
+  }
+}
+
+// Thresholds from the last interval, recorded without precipitation: its maximum or a quantile of
+// the group maximum per snapshot, e.g. q99: about 1 % of the snapshots have a bin above the threshold.
+// With the energy gate ("Gate" = "energy") the maximum is exact, but the gated snapshots enter the
+// quantiles with the lowest threshold, so quantile thresholds only converge towards the noise floor
+// if calibrated repeatedly. Calibrate with the gate off for the first calibration. A group whose bins
+// are all owned by lower groups has an empty sketch and keeps its threshold for the quantiles.
+void Statistics::Calibrate(CalibrationSource source) {
+  FFT_BIN_GROUP *binGroup;
+  uint16_t mag;
+
   for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
+    binGroup = &m_sensorData->binGroup[binGroupNr];
+    if (source != CALIBRATION_MAX && !(m_ownerGroups & (1UL << binGroupNr))) {
+      continue;
+    }
+    switch (source) {
+      case CALIBRATION_Q50:
+        mag = binGroup->magQ50;
+        break;
+      case CALIBRATION_Q95:
+        mag = binGroup->magQ95;
+        break;
+      case CALIBRATION_Q99:
+        mag = binGroup->magQ99;
+        break;
+      default:
+        mag = binGroup->magMax;
+        break;
+    }
     // avoid threshold to be 0
-    if (m_sensorData->binGroup[binGroupNr].magMax > 0) {
-      m_sensorData->binGroup[binGroupNr].magThresh = m_sensorData->binGroup[binGroupNr].magMax;
-    } else {
-      m_sensorData->binGroup[binGroupNr].magThresh = 1;
+    binGroup->magThresh = mag > 0 ? mag : 1;
+  }
+  ScaleThresholds();
+}
+
+// Integer thresholds of the interval per bin, the magnitudes are integers: mag > x <=> mag > floor(x).
+// Bins outside all groups are never counted, groups owning no bin do not limit the gate.
+void Statistics::ScaleThresholds() {
+  int32_t magThresh[NR_OF_BIN_GROUPS];
+  int32_t minThresh = INT32_MAX;
+
+  for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
+    magThresh[binGroupNr] = (int32_t)floorf(m_sensorData->binGroup[binGroupNr].magThresh + thresholdOffset);
+    if ((m_ownerGroups & (1UL << binGroupNr)) && magThresh[binGroupNr] < minThresh) {
+      minThresh = magThresh[binGroupNr];
     }
   }
+  // the energy gate skips snapshots with all magnitudes <= GetGateBound()
+  m_quietMag = (minThresh < 0 || !m_ownerGroups) ? 0 : (minThresh > UINT16_MAX ? UINT16_MAX : minThresh);
+  for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+    m_binThresh[binNr] = m_binGroups[binNr] ? magThresh[__builtin_ctz(m_binGroups[binNr])] : INT32_MAX;
+  }
 }
 
 void Statistics::ResetPreciAmountAcc() {
   m_sensorData->preciAmountAcc = 0;
 }
 
-void Statistics::Calc() {
-  ////uint8_t aboveThresh;
+// hop: new samples of the snapshot, the weight (time covered, 1 at 50 % overlap) is hop / (NR_OF_FFT_SAMPLES / 2).
+// Integer only and a single pass over the bins. The bins above threshold are summed up per group,
+// the running aggregates of the groups are updated once per snapshot, so GetCurrent() reads the
+// interval at any time in O(groups).
+// Against the former float accumulation the results differ by the rounding of the float sums, the
+// former truncation of the group sum to uint32 and the rounding of the Q20 reciprocals (magAVGkorr,
+// magAboveThreshCnt, bin 1 has the largest reciprocal error).
+void Statistics::Calc(uint16_t hop) {
+  const uint16_t *mag = m_sensorData->bin.mag;
+  uint16_t *magMax = m_sensorData->bin.magMax;
+  uint64_t *magSum = m_sensorData->bin.magSum;
+  uint32_t snapshotMag = 0;
+  uint64_t snapshotMagKorr = 0;
+  uint64_t magKorr;
+  uint32_t touchedGroups = 0;
+  uint32_t groups;
+  uint8_t binGroupNr;
+  uint8_t owner;
+  uint16_t snapshotMax[NR_OF_BIN_GROUPS + 1];    // maximum of the bins a group owns, last: bins of no group
+  uint16_t maxFloor = UINT16_MAX;
+
+  memset(snapshotMax, 0, sizeof(snapshotMax));
+
+  m_validHops += hop;
+  m_sliceHops += hop;
+  m_sliceValidSnapshots++;
   
   for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {    
-    if (m_sensorData->bin[binNr].mag > m_sensorData->bin[binNr].magMax) {
-      m_sensorData->bin[binNr].magMax = m_sensorData->bin[binNr].mag;
+    owner = m_binOwner[binNr];
+    if (mag[binNr] > snapshotMax[owner]) {
+      snapshotMax[owner] = mag[binNr];
     }
-  }
-    
-  // ignore magnitudes below threshold
-  for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) { 
-    ////aboveThresh = 0;
-    // scan through all bins within the group
-    for (uint16_t binNr = m_sensorData->binGroup[binGroupNr].firstBin; binNr <= m_sensorData->binGroup[binGroupNr].lastBin; binNr++) {
-      if (m_sensorData->bin[binNr].mag > (m_sensorData->binGroup[binGroupNr].magThresh + thresholdOffset)) {
-        m_sensorData->bin[binNr].magSum += m_sensorData->bin[binNr].mag;
-        m_sensorData->binGroup[binGroupNr].magAboveThreshCnt += 1 / dropInFOVsnapshots[binNr];    // TODO: Use precalculated values
-        ////aboveThresh = 1;
+
+    if (mag[binNr] > magMax[binNr]) {
+      magMax[binNr] = mag[binNr];
+
+      // bin 0 is not part of the maximum of all bins
+      if (binNr > 0 && mag[binNr] > m_magMax) {
+        m_magMax = mag[binNr];
+      }
+      groups = m_binGroups[binNr];
+      while (groups) {
+        binGroupNr = __builtin_ctz(groups);
+        groups &= groups - 1;
+        if (mag[binNr] > m_groupMagMax[binGroupNr]) {
+          m_groupMagMax[binGroupNr] = mag[binNr];
+        }
+      }
+    }
+    if (binNr > 0 && magMax[binNr] < maxFloor) {
+      maxFloor = magMax[binNr];
+    }
+
+    // ignore magnitudes below threshold
+    if ((int32_t)mag[binNr] > m_binThresh[binNr]) {
+      magSum[binNr] += (uint32_t)mag[binNr] * hop;
+      magKorr = (uint64_t)mag[binNr] * aboveThreshWeight[binNr];
+      snapshotMag += mag[binNr];
+      snapshotMagKorr += magKorr;
+
+      groups = m_binGroups[binNr];
+      touchedGroups |= groups;
+      while (groups) {
+        binGroupNr = __builtin_ctz(groups);
+        groups &= groups - 1;
+        m_snapshotMag[binGroupNr] += mag[binNr];
+        m_snapshotMagKorr[binGroupNr] += magKorr;
+        m_snapshotAboveThresh[binGroupNr] += aboveThreshWeight[binNr];
       }
     }
-    ////if (aboveThresh) {
-    ////  m_sensorData->binGroup[binGroupNr].magAboveThreshCnt++;
-    ////}
+  }
+
+  m_maxFloor = maxFloor;
+  m_magSum += (uint64_t)snapshotMag * hop;
+  m_magSumKorr += (snapshotMagKorr * hop) >> STAT_HOP_UNIT_bit;
+  AddSnapshotToGroups(touchedGroups, hop);
+
+  groups = m_ownerGroups;
+  while (groups) {
+    binGroupNr = __builtin_ctz(groups);
+    groups &= groups - 1;
+    AddToSketch(binGroupNr, snapshotMax[binGroupNr]);
   }
 }
 
-void Statistics::Finalize() {
-  uint32_t magSumGroup;
-  float magSumGroupKorr;
-  float magSumGroupKorrCal;
-  float magSumGroupKorrCalThresh;
-  float maxMagAVGkorr;
-  float maxMagAboveThreshCnt;
-  uint32_t nrOfBinsInGroup;
-
-  // bin-level statistics
-  m_sensorData->magAVG = 0;
-  m_sensorData->magAVGkorr = 0;
-  m_sensorData->magMax = 0;
-  
-  for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
-    m_sensorData->bin[binNr].magAVG = m_sensorData->bin[binNr].magSum / m_sensorData->snapshotValidCtr;
-    m_sensorData->bin[binNr].magAVGkorr = m_sensorData->bin[binNr].magAVG / dropInFOVsnapshots[binNr];
-
-    if (binNr > 0) {
-      m_sensorData->magAVG += m_sensorData->bin[binNr].magAVG;
-      m_sensorData->magAVGkorr += m_sensorData->bin[binNr].magAVGkorr;
-      
-      if (m_sensorData->bin[binNr].magMax > m_sensorData->magMax) {
-        m_sensorData->magMax = m_sensorData->bin[binNr].magMax;
-      }
+// true if the group average sumA / nA is above sumB / nB, without division
+static bool IsAboveAverage(uint64_t sumA, uint16_t nA, uint64_t sumB, uint16_t nB) {
+  if (nB == 0) {
+    return sumA > 0;
+  }
+  // keeps the products below 2^64 (up to 1024 bins per group)
+  while ((sumA | sumB) >> 54) {
+    sumA >>= 1;
+    sumB >>= 1;
+  }
+  return sumA * nB > sumB * nA;
+}
+
+// Adds the group sums of the snapshot to the running aggregates and updates the dominant group
+// candidates. The sums only grow during an interval, so only the groups of the snapshot can
+// overtake the candidates. Ties go to the lower group number, like the scan of all groups.
+void Statistics::AddSnapshotToGroups(uint32_t groups, uint16_t hop) {
+  uint8_t binGroupNr;
+  uint8_t dom;
+  uint64_t magSumKorr;
+  uint64_t aboveThresh;
+
+  while (groups) {
+    binGroupNr = __builtin_ctz(groups);
+    groups &= groups - 1;
+
+    magSumKorr = (m_snapshotMagKorr[binGroupNr] * hop) >> STAT_HOP_UNIT_bit;
+    aboveThresh = (uint64_t)m_snapshotAboveThresh[binGroupNr] * hop;
+    m_groupMagSum[binGroupNr] += (uint64_t)m_snapshotMag[binGroupNr] * hop;
+    m_groupMagSumKorr[binGroupNr] += magSumKorr;
+    m_groupAboveThresh[binGroupNr] += aboveThresh;
+    m_sliceMagSumKorr[binGroupNr] += magSumKorr;
+    m_sliceAboveThresh[binGroupNr] += aboveThresh;
+    m_snapshotMag[binGroupNr] = 0;
+    m_snapshotMagKorr[binGroupNr] = 0;
+    m_snapshotAboveThresh[binGroupNr] = 0;
+
+    dom = m_domGroupMagAVGkorr;
+    if (binGroupNr != dom && (IsAboveAverage(m_groupMagSumKorr[binGroupNr], m_nrOfBinsInGroup[binGroupNr], m_groupMagSumKorr[dom], m_nrOfBinsInGroup[dom]) ||
+        (binGroupNr < dom && !IsAboveAverage(m_groupMagSumKorr[dom], m_nrOfBinsInGroup[dom], m_groupMagSumKorr[binGroupNr], m_nrOfBinsInGroup[binGroupNr])))) {
+      m_domGroupMagAVGkorr = binGroupNr;
+    }
+
+    dom = m_domGroupMagAboveThreshCnt;
+    if (m_groupAboveThresh[binGroupNr] > m_groupAboveThresh[dom] ||
+        (binGroupNr < dom && m_groupAboveThresh[binGroupNr] == m_groupAboveThresh[dom])) {
+      m_domGroupMagAboveThreshCnt = binGroupNr;
     }
   }
-  m_sensorData->magAVG /= NR_OF_BINS - 1;
-  m_sensorData->magAVGkorr /= NR_OF_BINS - 1;
+}
 
+// snapshot with all bin magnitudes below the thresholds, only the time it covers is counted.
+// The magnitudes are unknown, the sketches get their upper bound (the lowest threshold), so the
+// quantiles of an interval with gated snapshots are upper bounds, too.
+void Statistics::AddQuietSnapshot(uint16_t hop) {
+  uint32_t groups = m_ownerGroups;
+  uint8_t binGroupNr;
 
-  // group-level statistics
-  m_sensorData->DomGroupMagAVGkorr = 0;
-  m_sensorData->DomGroupMagAboveThreshCnt = 0;
-  maxMagAVGkorr = 0;
-  maxMagAboveThreshCnt = 0;
-  
-  for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
-    nrOfBinsInGroup = 0;
-    magSumGroup = 0;
-    magSumGroupKorr = 0;
-    m_sensorData->binGroup[binGroupNr].magMax = 0;
-   
-    // scan through all bins within the group
-    for (uint16_t binNr = m_sensorData->binGroup[binGroupNr].firstBin; binNr <= m_sensorData->binGroup[binGroupNr].lastBin; binNr++) {
-      magSumGroup += m_sensorData->bin[binNr].magSum;
-      magSumGroupKorr += m_sensorData->bin[binNr].magSum / dropInFOVsnapshots[binNr];
-      
-      if (m_sensorData->bin[binNr].magMax > m_sensorData->binGroup[binGroupNr].magMax) {
-        m_sensorData->binGroup[binGroupNr].magMax = m_sensorData->bin[binNr].magMax;
-      }
-      nrOfBinsInGroup++;
+  m_validHops += hop;
+  m_sliceHops += hop;
+  m_sliceValidSnapshots++;
+
+  while (groups) {
+    binGroupNr = __builtin_ctz(groups);
+    groups &= groups - 1;
+    AddToSketch(binGroupNr, m_quietMag);
+  }
+}
+
+// Log-linear bucket of a magnitude: exact below 2 * STAT_SKETCH_SUB, above STAT_SKETCH_SUB buckets per octave
+static uint8_t SketchBucket(uint16_t mag) {
+  uint8_t octave;
+
+  if (mag < 2 * STAT_SKETCH_SUB) {
+    return mag;
+  }
+  octave = 31 - __builtin_clz(mag) - STAT_SKETCH_SUB_bit;
+  return ((octave + 1) << STAT_SKETCH_SUB_bit) + ((mag >> octave) & (STAT_SKETCH_SUB - 1));
+}
+
+// Constant memory and integer only. A full bucket halves all buckets of the group, the proportions
+// and so the quantiles stay the same.
+void Statistics::AddToSketch(uint8_t binGroupNr, uint16_t mag) {
+  uint16_t *counts = m_sketch[binGroupNr];
+
+  if (++counts[SketchBucket(mag)] == UINT16_MAX) {
+    for (uint8_t bucket = 0; bucket < STAT_SKETCH_BUCKETS; bucket++) {
+      counts[bucket] = (counts[bucket] + 1) >> 1;
+    }
+  }
+}
+
+// Quantile (permille) of the group maximum per snapshot, linear interpolation within the bucket.
+// 0 without snapshots or for a group owning no bins.
+uint16_t Statistics::GetQuantile(uint8_t binGroupNr, uint16_t permille) {
+  const uint16_t *counts = m_sketch[binGroupNr];
+  uint32_t total = 0;
+  uint32_t below = 0;
+  uint32_t rank;
+  uint32_t low;
+  uint8_t octave;
+
+  for (uint8_t bucket = 0; bucket < STAT_SKETCH_BUCKETS; bucket++) {
+    total += counts[bucket];
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  rank = (uint64_t)total * permille / 1000;
+  for (uint8_t bucket = 0; bucket < STAT_SKETCH_BUCKETS; bucket++) {
+    if (below + counts[bucket] > rank) {
+      octave = bucket < 2 * STAT_SKETCH_SUB ? 0 : (bucket >> STAT_SKETCH_SUB_bit) - 1;
+      low = bucket < 2 * STAT_SKETCH_SUB ? bucket : (STAT_SKETCH_SUB + (bucket & (STAT_SKETCH_SUB - 1))) << octave;
+      low += ((rank - below) << octave) / counts[bucket];
+      return low < UINT16_MAX ? low : UINT16_MAX;
     }
-    m_sensorData->binGroup[binGroupNr].magAVG = magSumGroup / (float)nrOfBinsInGroup / (float)m_sensorData->snapshotValidCtr;
-    m_sensorData->binGroup[binGroupNr].magAVGkorr = magSumGroupKorr / (float)nrOfBinsInGroup / (float)m_sensorData->snapshotValidCtr;
+    below += counts[bucket];
+  }
+  return UINT16_MAX;
+}
+
+// zoom FFT snapshot, maximum and average only
+void Statistics::CalcZoom() {
+  const uint16_t *mag = m_sensorData->zoomBin.mag;
+  uint16_t *magMax = m_sensorData->zoomBin.magMax;
+  uint64_t *magSum = m_sensorData->zoomBin.magSum;
 
-    if (m_sensorData->binGroup[binGroupNr].magAVGkorr > maxMagAVGkorr) {
-      maxMagAVGkorr = m_sensorData->binGroup[binGroupNr].magAVGkorr;
-      m_sensorData->DomGroupMagAVGkorr = binGroupNr;
+  m_sensorData->zoomSnapshotCtr++;
+
+  for (uint16_t binNr = 0; binNr < NR_OF_ZOOM_BINS; binNr++) {
+    if (mag[binNr] > magMax[binNr]) {
+      magMax[binNr] = mag[binNr];
     }
+    magSum[binNr] += mag[binNr];
+  }
+}
+
+// Highest magnitude bound of a snapshot the energy gate may skip: below all thresholds (nothing is
+// counted) and not above the maximum of any bin, so the bin, group and overall maxima stay exact.
+// 0 until the first calculated snapshot of the interval, that one is never gated.
+// The bound of the gate covers bins 1 ... N/2-1, bin 0 (DC) may hold up to sqrt(2) times more,
+// its maximum is taken with a factor of 2/3.
+// The magnitude bound of a snapshot is taken from its energy, for broadband input it is some 20 to 40
+// times the level of a bin, and the bins in the stopband of the decimator (near N/2) keep the smallest
+// maximum low. So the gate only skips near-silent snapshots after a loud broadband event of the same
+// interval (replay "burst,10,0,10240,2000": half of the snapshots), never the noise floor of the sensor.
+uint16_t Statistics::GetGateBound() {
+  uint16_t bound = m_quietMag;
+
+  if (m_maxFloor < bound) {
+    bound = m_maxFloor;
+  }
+  if ((m_sensorData->bin.magMax[0] << 1) / 3 < bound) {
+    bound = (m_sensorData->bin.magMax[0] << 1) / 3;
+  }
+
+  return bound;
+}
+
+// Group-level values and the averages over all bins of the current interval from the running
+// aggregates, O(groups). data: m_sensorData or e.g. a copy of the groups for a consumer (the
+// bins of data are not used). The precipitation amount is calculated, not accumulated.
+// Without a valid snapshot in the interval (snapshotValidWeight 0) all averages are 0.
+void Statistics::GetCurrent(SensorData *data) {
+  FFT_BIN_GROUP *binGroup = data->binGroup;
+  float validHops = m_validHops;
+  float korrScale = validHops * ((1UL << STAT_RECIPROCAL_bit) >> STAT_HOP_UNIT_bit);
+  uint8_t domMagAVGkorr = m_domGroupMagAVGkorr;
+  uint8_t domMagAboveThreshCnt = m_domGroupMagAboveThreshCnt;
+
+  data->snapshotValidWeight = validHops / (1 << STAT_HOP_UNIT_bit);
+  if (m_validHops > 0) {
+    data->magAVG = m_magSum / validHops / (NR_OF_BINS - 1);
+    data->magAVGkorr = m_magSumKorr / korrScale / (NR_OF_BINS - 1);
+  } else {
+    data->magAVG = 0;
+    data->magAVGkorr = 0;
+  }
+  data->magMax = m_magMax;
 
-    if (m_sensorData->binGroup[binGroupNr].magAboveThreshCnt > maxMagAboveThreshCnt) {
-      maxMagAboveThreshCnt = m_sensorData->binGroup[binGroupNr].magAboveThreshCnt; 
-      m_sensorData->DomGroupMagAboveThreshCnt = binGroupNr;
+  for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
+    if (m_nrOfBinsInGroup[binGroupNr] > 0 && m_validHops > 0) {
+      binGroup[binGroupNr].magAVG = m_groupMagSum[binGroupNr] / (float)m_nrOfBinsInGroup[binGroupNr] / validHops;
+      binGroup[binGroupNr].magAVGkorr = m_groupMagSumKorr[binGroupNr] / (float)m_nrOfBinsInGroup[binGroupNr] / korrScale;
+    } else {
+      binGroup[binGroupNr].magAVG = 0;
+      binGroup[binGroupNr].magAVGkorr = 0;
     }
+    binGroup[binGroupNr].magAboveThreshCnt = m_groupAboveThresh[binGroupNr] / (float)((uint64_t)1 << (STAT_HOP_UNIT_bit + STAT_RECIPROCAL_bit));
+    binGroup[binGroupNr].magMax = m_groupMagMax[binGroupNr];
 
-    if (m_sensorData->binGroup[binGroupNr].magAboveThreshCnt > countThreshold) {
-      m_sensorData->binGroup[binGroupNr].magAVGkorrGated = m_sensorData->binGroup[binGroupNr].magAVGkorr;
+    if (binGroup[binGroupNr].magAboveThreshCnt > countThreshold) {
+      binGroup[binGroupNr].magAVGkorrGated = binGroup[binGroupNr].magAVGkorr;
     } else {
-      m_sensorData->binGroup[binGroupNr].magAVGkorrGated = 0;
+      binGroup[binGroupNr].magAVGkorrGated = 0;
     }
     
-    m_sensorData->binGroup[binGroupNr].magAVGkorrDom = 0;
-    m_sensorData->binGroup[binGroupNr].magAVGkorrDom2 = 0;
-    m_sensorData->binGroup[binGroupNr].magAboveThreshCntDom = 0;
+    binGroup[binGroupNr].magAVGkorrDom = 0;
+    binGroup[binGroupNr].magAVGkorrDom2 = 0;
+    binGroup[binGroupNr].magAboveThreshCntDom = 0;
   }
 
-  m_sensorData->binGroup[m_sensorData->DomGroupMagAVGkorr].magAVGkorrDom = m_sensorData->binGroup[m_sensorData->DomGroupMagAVGkorr].magAVGkorr;
-  m_sensorData->binGroup[m_sensorData->DomGroupMagAboveThreshCnt].magAVGkorrDom2 = m_sensorData->binGroup[m_sensorData->DomGroupMagAboveThreshCnt].magAVGkorr;                  // TEST: dom index from count, value from magAVG
-  m_sensorData->binGroup[m_sensorData->DomGroupMagAboveThreshCnt].magAboveThreshCntDom = m_sensorData->binGroup[m_sensorData->DomGroupMagAboveThreshCnt].magAboveThreshCnt;
+  data->DomGroupMagAVGkorr = domMagAVGkorr;
+  data->DomGroupMagAboveThreshCnt = domMagAboveThreshCnt;
+  binGroup[domMagAVGkorr].magAVGkorrDom = binGroup[domMagAVGkorr].magAVGkorr;
+  binGroup[domMagAboveThreshCnt].magAVGkorrDom2 = binGroup[domMagAboveThreshCnt].magAVGkorr;                  // TEST: dom index from count, value from magAVG
+  binGroup[domMagAboveThreshCnt].magAboveThreshCntDom = binGroup[domMagAboveThreshCnt].magAboveThreshCnt;
     
-  m_sensorData->preciAmount = 0;
-  if (m_sensorData->DomGroupMagAboveThreshCnt < DOM_GROUP_RAIN_FIRST) {
+  data->preciAmount = 0;
+  if (domMagAboveThreshCnt < DOM_GROUP_RAIN_FIRST) {
     // snowing
-  } else if (m_sensorData->DomGroupMagAboveThreshCnt <= DOM_GROUP_RAIN_LAST) {
+  } else if (domMagAboveThreshCnt <= DOM_GROUP_RAIN_LAST) {
     // raining
     for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
-      m_sensorData->preciAmount += m_sensorData->binGroup[binGroupNr].magAVGkorr * m_sensorData->binGroup[binGroupNr].preciAmountFactor;      
+      data->preciAmount += binGroup[binGroupNr].magAVGkorr * m_sensorData->binGroup[binGroupNr].preciAmountFactor;      
     }
-    m_sensorData->preciAmountAcc += m_sensorData->preciAmount;  
   } else {
     // hailing
   }
 }
 
+// End of the interval: the groups from the running aggregates, the averages of the single bins
+void Statistics::Finalize() {
+  float validHops = m_validHops;
+
+  GetCurrent(m_sensorData);
+  m_sensorData->preciAmountAcc += m_sensorData->preciAmount;
+
+  for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
+    m_sensorData->binGroup[binGroupNr].magQ50 = GetQuantile(binGroupNr, 500);
+    m_sensorData->binGroup[binGroupNr].magQ95 = GetQuantile(binGroupNr, 950);
+    m_sensorData->binGroup[binGroupNr].magQ99 = GetQuantile(binGroupNr, 990);
+  }
+
+  for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
+    m_sensorData->bin.magAVG[binNr] = (m_validHops > 0) ? m_sensorData->bin.magSum[binNr] / validHops : 0;
+    m_sensorData->bin.magAVGkorr[binNr] = m_sensorData->bin.magAVG[binNr] / dropInFOVsnapshots[binNr];
+  }
+
+  if (m_sensorData->zoomBinGroup) {
+    FinalizeZoom();
+  }
+}
+
+// End of a rollup slice (ROLLUP_BASE_SECONDS of signal, snapshots: all snapshots of the slice).
+// The groups of the slice are passed to the rollup store, like GetCurrent() does for the interval.
+// The interval formula gives the amount of a publish interval, the slice gets its share of it, so the
+// records of a level add up to the amounts accumulated by preciAmountAcc over the same time.
+void Statistics::FinalizeSlice(uint32_t snapshots) {
+  RollupRecord record;
+  float korrScale = (float)m_sliceHops * ((1UL << STAT_RECIPROCAL_bit) >> STAT_HOP_UNIT_bit);
+  float korr[NR_OF_BIN_GROUPS];
+  float maxKorr = 0;
+  uint64_t maxAboveThresh = 0;
+
+  if (Rollup::IsEnabled()) {
+    record.validWeight = (float)m_sliceHops / (1 << STAT_HOP_UNIT_bit);
+    record.snapshots = snapshots;
+    record.invalidSnapshots = snapshots > m_sliceValidSnapshots ? snapshots - m_sliceValidSnapshots : 0;
+    record.domGroupMagAVGkorr = 0;
+    record.domGroupMagAboveThreshCnt = 0;
+    record.preciAmount = 0;
+
+    for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
+      korr[binGroupNr] = (m_nrOfBinsInGroup[binGroupNr] > 0 && m_sliceHops > 0) ? m_sliceMagSumKorr[binGroupNr] / (float)m_nrOfBinsInGroup[binGroupNr] / korrScale : 0;
+      record.groupMagAVGkorr[binGroupNr] = korr[binGroupNr] * ROLLUP_KORR_SCALE < 65535.0f ? (uint16_t)(korr[binGroupNr] * ROLLUP_KORR_SCALE + 0.5f) : 65535;
+      if (korr[binGroupNr] > maxKorr) {
+        maxKorr = korr[binGroupNr];
+        record.domGroupMagAVGkorr = binGroupNr;
+      }
+      if (m_sliceAboveThresh[binGroupNr] > maxAboveThresh) {
+        maxAboveThresh = m_sliceAboveThresh[binGroupNr];
+        record.domGroupMagAboveThreshCnt = binGroupNr;
+      }
+    }
+
+    if (record.domGroupMagAboveThreshCnt >= DOM_GROUP_RAIN_FIRST && record.domGroupMagAboveThreshCnt <= DOM_GROUP_RAIN_LAST) {
+      for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
+        record.preciAmount += korr[binGroupNr] * m_sensorData->binGroup[binGroupNr].preciAmountFactor;
+      }
+      record.preciAmount *= m_sliceAmountScale;
+    }
+
+    Rollup::Add(&record);
+  }
+
+  ResetSlice();
+}
+
+void Statistics::ResetSlice() {
+  memset(m_sliceMagSumKorr, 0, sizeof(m_sliceMagSumKorr));
+  memset(m_sliceAboveThresh, 0, sizeof(m_sliceAboveThresh));
+  m_sliceHops = 0;
+  m_sliceValidSnapshots = 0;
+}
+
+void Statistics::FinalizeZoom() {
+  uint64_t magSumGroup;
+  uint16_t nrOfBinsInGroup;
+  uint32_t snapshots = m_sensorData->zoomSnapshotCtr > 0 ? m_sensorData->zoomSnapshotCtr : 1;
+
+  for (uint16_t binNr = 0; binNr < NR_OF_ZOOM_BINS; binNr++) {
+    m_sensorData->zoomBin.magAVG[binNr] = (float)m_sensorData->zoomBin.magSum[binNr] / snapshots;
+  }
+
+  for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_ZOOM_BIN_GROUPS; binGroupNr++) {
+    magSumGroup = 0;
+    nrOfBinsInGroup = 0;
+    m_sensorData->zoomBinGroup[binGroupNr].magMax = 0;
+
+    for (uint16_t binNr = m_sensorData->zoomBinGroup[binGroupNr].firstBin; binNr <= m_sensorData->zoomBinGroup[binGroupNr].lastBin; binNr++) {
+      magSumGroup += m_sensorData->zoomBin.magSum[binNr];
+      if (m_sensorData->zoomBin.magMax[binNr] > m_sensorData->zoomBinGroup[binGroupNr].magMax) {
+        m_sensorData->zoomBinGroup[binGroupNr].magMax = m_sensorData->zoomBin.magMax[binNr];
+      }
+      nrOfBinsInGroup++;
+    }
+    m_sensorData->zoomBinGroup[binGroupNr].magAVG = (float)magSumGroup / nrOfBinsInGroup / snapshots;
+  }
+}
+
 void Statistics::Reset()
 {
   // bin-level
-  for (uint16_t binNr = 0; binNr < NR_OF_BINS; binNr++) {
-    m_sensorData->bin[binNr].magSum = 0;
-    m_sensorData->bin[binNr].magMax = 0;
-  }
+  memset(m_sensorData->bin.magSum, 0, NR_OF_BINS * sizeof(uint64_t));
+  memset(m_sensorData->bin.magMax, 0, NR_OF_BINS * sizeof(uint16_t));
 
   // group-level
   for (uint8_t binGroupNr = 0; binGroupNr < NR_OF_BIN_GROUPS; binGroupNr++) {
     m_sensorData->binGroup[binGroupNr].magAboveThreshCnt = 0;
   }
 
+  // running aggregates
+  memset(m_groupMagSum, 0, sizeof(m_groupMagSum));
+  memset(m_groupMagSumKorr, 0, sizeof(m_groupMagSumKorr));
+  memset(m_groupAboveThresh, 0, sizeof(m_groupAboveThresh));
+  memset(m_groupMagMax, 0, sizeof(m_groupMagMax));
+  memset(m_snapshotMag, 0, sizeof(m_snapshotMag));
+  memset(m_snapshotMagKorr, 0, sizeof(m_snapshotMagKorr));
+  memset(m_snapshotAboveThresh, 0, sizeof(m_snapshotAboveThresh));
+  memset(m_sketch, 0, sizeof(m_sketch));
+  m_magSum = 0;
+  m_magSumKorr = 0;
+  m_magMax = 0;
+  m_maxFloor = 0;
+  m_domGroupMagAVGkorr = 0;
+  m_domGroupMagAboveThreshCnt = 0;
+  ScaleThresholds();
+
+  if (m_sensorData->zoomBinGroup) {
+    memset(m_sensorData->zoomBin.magSum, 0, NR_OF_ZOOM_BINS * sizeof(uint64_t));
+    memset(m_sensorData->zoomBin.magMax, 0, NR_OF_ZOOM_BINS * sizeof(uint16_t));
+  }
+
   m_sensorData->ADCpeakSample = 0;
   m_sensorData->clippingCtr = 0;
   m_sensorData->RbOvCtr = 0;
+  m_sensorData->RbDroppedSamples = 0;
   m_sensorData->snapshotCtr = 0;
   m_sensorData->snapshotValidCtr = 0;
+  m_sensorData->snapshotValidWeight = 0;
+  m_validHops = 0;
+  m_sensorData->hopWidenedCtr = 0;
+  m_sensorData->gatedSnapshotCtr = 0;
+  m_sensorData->sdftMaxDeviation = 0;
+  m_sensorData->zoomSnapshotCtr = 0;
 }
-
+
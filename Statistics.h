@@ -5,13 +5,49 @@
 #include "GlobalDefines.h"
 #include "Settings.h"
 #include "SensorData.h"
+#include "Rollup.h"
+
+#define DROP_IN_FOV_TIME_FREQ       161.33335    // FOV crossing time * doppler frequency
+#define STAT_RECIPROCAL_bit         20           // Q20 reciprocals of the drop visibility, sum of a group < 2^32
+#define STAT_HOP_UNIT_bit           (NR_OF_FFT_SAMPLES_bit - 1)    // hop of the snapshot weight 1 (50 % overlap)
+#define STAT_SKETCH_SUB_bit         3            // quantile sketch: 8 buckets per octave (< 12.5 % wide), below 16 exact
+#define STAT_SKETCH_SUB             (1 << STAT_SKETCH_SUB_bit)
+#define STAT_SKETCH_BUCKETS         ((16 - STAT_SKETCH_SUB_bit + 1) << STAT_SKETCH_SUB_bit)    // uint16 magnitudes
+
+#if NR_OF_BIN_GROUPS > 32
+#error "The bin -> group table holds the groups of a bin in a 32 bit mask"
+#endif
 
 class Statistics {
 public:
+  enum CalibrationSource {
+    CALIBRATION_MAX,      // maximum of the interval
+    CALIBRATION_Q50,      // quantiles of the group maximum per snapshot
+    CALIBRATION_Q95,
+    CALIBRATION_Q99
+  };
+
+  static CalibrationSource CalibrationSourceFromString(String source) {
+    if (source == "q50") {
+      return CALIBRATION_Q50;
+    }
+    if (source == "q95") {
+      return CALIBRATION_Q95;
+    }
+    return source == "q99" ? CALIBRATION_Q99 : CALIBRATION_MAX;
+  }
+
   void Begin(Settings *settings, SensorData *sensorData);
-  void Calibrate();
-  void Calc();
+  void SetBinGroups();
+  void Calibrate(CalibrationSource source = CALIBRATION_MAX);
+  void Calc(uint16_t hop);
+  void AddQuietSnapshot(uint16_t hop);
+  void CalcZoom();
+  uint16_t GetGateBound();
+  void GetCurrent(SensorData *data);
   void Finalize();
+  void FinalizeSlice(uint32_t snapshots);
+  void ResetSlice();
   void ResetPreciAmountAcc();
   void Reset();
 
@@ -20,9 +56,49 @@ private:
   Settings *m_settings;
   float thresholdOffset;
   float countThreshold;
+  float m_sliceAmountScale;                       // ROLLUP_BASE_SECONDS / publish interval
+  uint32_t m_binGroups[NR_OF_BINS];               // bin -> groups containing it (bit mask), 0: not in any group
+  int32_t m_binThresh[NR_OF_BINS];                // floor(magThresh + thresholdOffset) of the lowest group of the bin
+  uint16_t m_nrOfBinsInGroup[NR_OF_BIN_GROUPS];
+  uint8_t m_binOwner[NR_OF_BINS];                 // lowest group of the bin (its threshold), NR_OF_BIN_GROUPS: none
+  uint32_t m_ownerGroups;                         // groups owning at least one bin
+  uint16_t m_quietMag;                            // upper bound of the magnitudes of a gated snapshot
+  uint16_t m_maxFloor;                            // smallest bin maximum of the interval, see GetGateBound()
+  uint32_t m_validHops;                           // samples covered by the valid snapshots
+
+  // running aggregates of the interval, updated per snapshot
+  uint64_t m_groupMagSum[NR_OF_BIN_GROUPS];       // sum of mag * hop
+  uint64_t m_groupMagSumKorr[NR_OF_BIN_GROUPS];   // sum of weight * mag / dropInFOVsnapshots, Q20
+  uint64_t m_groupAboveThresh[NR_OF_BIN_GROUPS];  // sum of hop * Q20 reciprocal of the bins above threshold
+  uint16_t m_groupMagMax[NR_OF_BIN_GROUPS];
+  uint64_t m_magSum;                              // the same over all bins
+  uint64_t m_magSumKorr;
+  uint16_t m_magMax;
+  uint8_t m_domGroupMagAVGkorr;                   // dominant group candidates
+  uint8_t m_domGroupMagAboveThreshCnt;
+
+  // quantile sketches of the interval: histogram of the maximum of the bins a group owns, per snapshot
+  uint16_t m_sketch[NR_OF_BIN_GROUPS][STAT_SKETCH_BUCKETS];
+
+  // sums of the current rollup slice (ROLLUP_BASE_SECONDS), independent of the interval
+  uint64_t m_sliceMagSumKorr[NR_OF_BIN_GROUPS];
+  uint64_t m_sliceAboveThresh[NR_OF_BIN_GROUPS];
+  uint32_t m_sliceHops;
+  uint32_t m_sliceValidSnapshots;
+
+  // group sums of the current snapshot, zero between the snapshots
+  uint32_t m_snapshotMag[NR_OF_BIN_GROUPS];
+  uint64_t m_snapshotMagKorr[NR_OF_BIN_GROUPS];
+  uint32_t m_snapshotAboveThresh[NR_OF_BIN_GROUPS];
 
   void filterMagMaxGroup();
+  void ScaleThresholds();
+  void AddBinRange(uint8_t binGroupNr, long from, long to);
+  void AddSnapshotToGroups(uint32_t groups, uint16_t hop);
+  void AddToSketch(uint8_t binGroupNr, uint16_t mag);
+  uint16_t GetQuantile(uint8_t binGroupNr, uint16_t permille);
   float noiseDebiasing(float scaleStart, float scaleStop, float scaleStep);
+  void FinalizeZoom();
 };
 
 #endif
@@ -0,0 +1,60 @@
+#include "StreamSampleSource.h"
+
+StreamSampleSource::StreamSampleSource(Stream *stream) {
+  m_stream = stream;
+}
+
+bool StreamSampleSource::Begin(uint8_t /*adcPin*/, BlockHandler blockHandler) {
+  m_blockHandler = blockHandler;
+  return m_stream != NULL;
+}
+
+void StreamSampleSource::Start() {
+  m_isRunning = !m_isFinished;
+}
+
+void StreamSampleSource::Stop() {
+  m_isRunning = false;
+}
+
+bool StreamSampleSource::IsRunning() {
+  return m_isRunning;
+}
+
+String StreamSampleSource::Name() {
+  return "stream";
+}
+
+uint32_t StreamSampleSource::GetSampleCount() {
+  return m_sampleCount;
+}
+
+bool StreamSampleSource::IsFinished() {
+  return m_isFinished;
+}
+
+void StreamSampleSource::Handle() {
+  uint8_t *data = (uint8_t *)m_block;
+  uint16_t count;
+
+  if (!m_isRunning) {
+    return;
+  }
+
+  count = m_stream->readBytes(data, sizeof(m_block)) / sizeof(uint16_t);
+
+  // the ESP32 is little endian, only the 12 bit range is valid
+  for (uint16_t i = 0; i < count; i++) {
+    m_block[i] &= 0x0FFF;
+  }
+
+  if (count) {
+    m_blockHandler(m_block, count);
+    m_sampleCount += count;
+  }
+
+  if (count < STREAM_BLOCK_SIZE) {
+    m_isFinished = true;
+    m_isRunning = false;
+  }
+}
@@ -0,0 +1,33 @@
+#ifndef __STREAMSAMPLESOURCE__h
+#define __STREAMSAMPLESOURCE__h
+
+#include "Arduino.h"
+#include "SampleSource.h"
+
+#define STREAM_BLOCK_SIZE            256      // samples per Handle() call
+
+// Reads recorded raw ADC values (uint16_t, little endian) from a stream, e.g. a file, and hands them
+// to the decimator block by block. Not paced to SAMPLE_RATE: every Handle() call delivers one block,
+// so the signal processing never falls behind. Stops at the end of the stream.
+class StreamSampleSource : public SampleSource {
+public:
+  StreamSampleSource(Stream *stream);
+  bool Begin(uint8_t adcPin, BlockHandler blockHandler);
+  void Start();
+  void Stop();
+  void Handle();
+  bool IsRunning();
+  String Name();
+  uint32_t GetSampleCount();
+  bool IsFinished();
+
+private:
+  Stream *m_stream;
+  BlockHandler m_blockHandler;
+  uint16_t m_block[STREAM_BLOCK_SIZE];
+  uint32_t m_sampleCount = 0;
+  bool m_isRunning = false;
+  bool m_isFinished = false;
+};
+
+#endif
@@ -0,0 +1,171 @@
+#include "TimerSampleSource.h"
+#include "Profiler.h"
+#include "soc/sens_reg.h"
+#include "xtensa/hal.h"
+
+volatile byte TimerSampleSource::m_adcPin;
+SPSCRingBuffer<uint16_t, TIMER_RAW_RB_SIZE> TimerSampleSource::m_rawRb;
+volatile uint32_t TimerSampleSource::m_notReadyCount;
+volatile bool TimerSampleSource::m_isrStatsReset = true;
+volatile uint32_t TimerSampleSource::m_isrCount;
+volatile uint32_t TimerSampleSource::m_isrCyclesSum;
+volatile uint32_t TimerSampleSource::m_isrCyclesMin;
+volatile uint32_t TimerSampleSource::m_isrCyclesMax;
+volatile uint32_t TimerSampleSource::m_isrHistogram[ISR_HISTOGRAM_BUCKETS];
+
+bool TimerSampleSource::Begin(uint8_t adcPin, BlockHandler blockHandler) {
+  int8_t channel = digitalPinToAnalogChannel(adcPin);
+
+  // the register path serves ADC1 only (ADC2 is shared with WiFi)
+  if (channel < 0 || channel > 7) {
+    return false;
+  }
+
+  m_adcPin = adcPin;
+  m_blockHandler = blockHandler;
+
+  // Initialize the ADC, the driver configures the SAR controller for software start
+  analogSetAttenuation(ADC_6db);
+  analogSetWidth(12);
+  analogSetCycles(8);
+  analogSetSamples(1);
+  analogSetClockDiv(1);
+  adcAttachPin(m_adcPin);
+  analogRead(m_adcPin);
+
+  // Select the pad once, the ISR only starts conversions
+  SET_PERI_REG_BITS(SENS_SAR_MEAS_START1_REG, SENS_SAR1_EN_PAD, (1 << channel), SENS_SAR1_EN_PAD_S);
+
+  // Initialize the sampling timer, once (every timerBegin() allocates a hardware timer)
+  if (!m_timer) {
+    m_timer = timerBegin(0, CPU_CLOCK / SAMPLE_RATE, true);
+    timerAlarmWrite(m_timer, 1, true);
+    timerAttachInterrupt(m_timer, &TimerSampleSource::onTimer, true);
+  }
+
+  return true;
+}
+
+void TimerSampleSource::Start() {
+  m_rawRb.Reset();
+  m_notReadyCount = 0;
+  if (m_timer) {
+    StartConversion();
+    timerAlarmEnable(m_timer);
+    m_isRunning = true;
+  }
+}
+
+void TimerSampleSource::Stop() {
+  if (m_timer) {
+    timerAlarmDisable(m_timer);
+  }
+  m_isRunning = false;
+}
+
+bool TimerSampleSource::IsRunning() {
+  return m_isRunning;
+}
+
+String TimerSampleSource::Name() {
+  return "timer";
+}
+
+uint32_t TimerSampleSource::GetDroppedCount() {
+  return m_rawRb.GetDroppedCount() + m_notReadyCount;
+}
+
+// Copies the interrupt statistics and lets the ISR start over. The values are read while the ISR
+// keeps running, so an interrupt in between may be missing from the average.
+bool TimerSampleSource::TakeIsrStatistics(IsrStatistics *stats) {
+  if (m_isrStatsReset) {
+    stats->count = 0;
+    return true;
+  }
+
+  stats->count = m_isrCount;
+  stats->minCycles = m_isrCyclesMin;
+  stats->maxCycles = m_isrCyclesMax;
+  stats->avgCycles = stats->count > 0 ? m_isrCyclesSum / stats->count : 0;
+  for (uint8_t i = 0; i < ISR_HISTOGRAM_BUCKETS; i++) {
+    stats->histogram[i] = m_isrHistogram[i];
+  }
+  m_isrStatsReset = true;
+
+  return true;
+}
+
+// Hands the raw samples stored since the last call to the decimator, block by block, so the ISR
+// can reuse the space early. If Handle() is not called for more than 200 ms, the raw ringbuffer is
+// full and the ISR drops the new samples, they are counted there (GetDroppedCount()).
+void TimerSampleSource::Handle() {
+  uint32_t pending = m_rawRb.Available();
+  uint16_t count;
+
+  while (pending) {
+    count = m_rawRb.Read(m_block, pending < TIMER_BLOCK_SIZE ? pending : TIMER_BLOCK_SIZE);
+    pending -= count;
+    m_blockHandler(m_block, count);
+  }
+}
+
+// A rising edge of the start bit triggers a conversion of the selected pad
+void IRAM_ATTR TimerSampleSource::StartConversion() {
+  CLEAR_PERI_REG_MASK(SENS_SAR_MEAS_START1_REG, SENS_MEAS1_START_SAR);
+  SET_PERI_REG_MASK(SENS_SAR_MEAS_START1_REG, SENS_MEAS1_START_SAR);
+}
+
+void IRAM_ATTR TimerSampleSource::onTimer()
+{
+  uint32_t startCycles = xthal_get_ccount();
+  uint32_t cycles;
+  uint8_t bucket;
+
+#ifdef DEBUG
+  digitalWrite(DEBUG_GPIO_ISR, HIGH);
+#endif
+
+  // The conversion (a few us) was started one sample period ago and is normally done. If not, the
+  // sample is skipped and counted, the running conversion delivers the next one.
+  if (GET_PERI_REG_MASK(SENS_SAR_MEAS_START1_REG, SENS_MEAS1_DONE_SAR)) {
+    m_rawRb.Put(GET_PERI_REG_BITS2(SENS_SAR_MEAS_START1_REG, SENS_MEAS1_DATA_SAR, SENS_MEAS1_DATA_SAR_S));
+    StartConversion();
+  } else {
+    m_notReadyCount++;
+  }
+
+  if ((m_isrCount & (PROFILER_ISR_DECIMATION - 1)) == 0) {
+    Profiler::Record(PROFILE_ISR, startCycles);
+  }
+
+#ifdef DEBUG
+  digitalWrite(DEBUG_GPIO_ISR, LOW);
+#endif
+
+  if (m_isrStatsReset) {
+    m_isrCount = 0;
+    m_isrCyclesSum = 0;
+    m_isrCyclesMin = UINT32_MAX;
+    m_isrCyclesMax = 0;
+    for (uint8_t i = 0; i < ISR_HISTOGRAM_BUCKETS; i++) {
+      m_isrHistogram[i] = 0;
+    }
+    m_isrStatsReset = false;
+  }
+
+  // logarithmic buckets starting at 64 cycles
+  cycles = xthal_get_ccount() - startCycles;
+  bucket = cycles < 64 ? 0 : 26 - __builtin_clz(cycles);
+  if (bucket >= ISR_HISTOGRAM_BUCKETS) {
+    bucket = ISR_HISTOGRAM_BUCKETS - 1;
+  }
+  m_isrHistogram[bucket]++;
+  m_isrCount++;
+  m_isrCyclesSum += cycles;
+  if (cycles < m_isrCyclesMin) {
+    m_isrCyclesMin = cycles;
+  }
+  if (cycles > m_isrCyclesMax) {
+    m_isrCyclesMax = cycles;
+  }
+}
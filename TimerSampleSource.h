@@ -0,0 +1,53 @@
+#ifndef __TIMERSAMPLESOURCE__h
+#define __TIMERSAMPLESOURCE__h
+
+#include "Arduino.h"
+#include "GlobalDefines.h"
+#include "SampleSource.h"
+#include "SPSCRingBuffer.h"
+
+#define TIMER_RAW_RB_SIZE            8192     // raw samples (200 ms)
+#define TIMER_BLOCK_SIZE             256      // samples handed to the decimator at once
+
+// One SAR ADC1 conversion per timer interrupt, started and read directly through the RTC sensor
+// registers. The ISR takes the result of the conversion started in the previous interrupt and
+// starts the next one, so it never waits for the ADC and calls no (flash resident, locking) driver
+// functions. If that conversion is not done yet, the sample is skipped and counted as dropped.
+// The raw values pass a lock-free ringbuffer, samples the ISR finds no space for are counted there.
+// Handle() hands the raw values to the decimator in blocks.
+// The execution time of every interrupt is measured with the CPU cycle counter, from the entry of
+// onTimer(), the interrupt dispatch of the Arduino core is not included.
+// Fallback if the I2S ADC mode is not available.
+class TimerSampleSource : public SampleSource {
+public:
+  bool Begin(uint8_t adcPin, BlockHandler blockHandler);
+  void Start();
+  void Stop();
+  void Handle();
+  bool IsRunning();
+  String Name();
+  bool TakeIsrStatistics(IsrStatistics *stats);
+  uint32_t GetDroppedCount();
+
+private:
+  hw_timer_t *m_timer = NULL;
+  bool m_isRunning = false;
+  static volatile byte m_adcPin;
+  BlockHandler m_blockHandler;
+  uint16_t m_block[TIMER_BLOCK_SIZE];
+  static SPSCRingBuffer<uint16_t, TIMER_RAW_RB_SIZE> m_rawRb;
+  static volatile uint32_t m_notReadyCount;         // samples skipped, the conversion was not done
+
+  // written by the ISR only, cleared there on request of TakeIsrStatistics()
+  static volatile bool m_isrStatsReset;
+  static volatile uint32_t m_isrCount;
+  static volatile uint32_t m_isrCyclesSum;
+  static volatile uint32_t m_isrCyclesMin;
+  static volatile uint32_t m_isrCyclesMax;
+  static volatile uint32_t m_isrHistogram[ISR_HISTOGRAM_BUCKETS];
+
+  static void IRAM_ATTR StartConversion();
+  static void IRAM_ATTR onTimer();
+};
+
+#endif
@@ -80,4 +80,29 @@ String Tools::UTF8ToASCII(String utf8) {
     }
   }
   return result;
-}
\ No newline at end of file
+}
+// Returns the comma separated parameter at position index, e.g. GetParam("tone,5,1000", 1, "") returns "5"
+String Tools::GetParam(String params, byte index, String defaultValue) {
+  int from = 0;
+
+  for (byte i = 0; i < index; i++) {
+    from = params.indexOf(',', from);
+    if (from == -1) {
+      return defaultValue;
+    }
+    from++;
+  }
+
+  int to = params.indexOf(',', from);
+  String result = (to == -1) ? params.substring(from) : params.substring(from, to);
+  result.trim();
+
+  return result.length() > 0 ? result : defaultValue;
+}
+
+// Deterministic LCG noise from -amplitude to amplitude, start with state = TOOLS_NOISE_SEED. The test
+// signals (replay, benchmarks, accuracy test) are the same on every run and on the host build.
+int16_t Tools::NextNoise(uint32_t &state, uint16_t amplitude) {
+  state = state * 1664525 + 1013904223;
+  return ((int32_t)(state >> 16) - 32768) * amplitude / 32768;
+}
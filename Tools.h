@@ -5,6 +5,8 @@
 #include "soc/efuse_reg.h"
 #include "IPAddress.h"
 
+#define TOOLS_NOISE_SEED           0x12345678
+
 class Tools {
 public:
   static String GetChipId();
@@ -12,6 +14,8 @@ public:
   static IPAddress IPAddressFromString(String ipString);
   static byte UTF8ToASCII(byte ascii);
   static String UTF8ToASCII(String utf8);
+  static String GetParam(String params, byte index, String defaultValue);
+  static int16_t NextNoise(uint32_t &state, uint16_t amplitude);
 
 };
 
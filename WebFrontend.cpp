@@ -4,6 +4,8 @@
 #include "Help.h"
 #include "Tools.h"
 #include "GlobalDefines.h"
+#include "Profiler.h"
+#include "Rollup.h"
 
 WebFrontend::WebFrontend(int port, Settings *settings) : m_webserver(port) {
   m_port = port;
@@ -78,6 +80,7 @@ String WebFrontend::GetBinGroupRow(byte nbr, uint16_t lastBin) {
   String result = "";
   String bgtKey = "BG" + String(nbr) + "T";
   String bgfKey = "BG" + String(nbr) + "F";
+  String bgrKey = "BG" + String(nbr) + "R";
   
   result += "<tr><td><label>Bin group ";
   result += String(nbr);
@@ -85,10 +88,12 @@ String WebFrontend::GetBinGroupRow(byte nbr, uint16_t lastBin) {
   if (nbr == 0) {
     result += "1 ";
   }
-  result += "to:&nbsp;</label><input name='" + bgtKey + "' size='8' maxlength='3' Value='";
+  result += "to:&nbsp;</label><input name='" + bgtKey + "' size='8' maxlength='4' Value='";
   result += m_settings->Get(bgtKey, String(defaultBinGroupBoundary[nbr]));
   result += "'></input>&nbsp;&nbsp;&nbsp;<label>Factor:&nbsp;</label><input name='" + bgfKey + "' size='8' maxlength='10' Value='";
   result += m_settings->Get(bgfKey, "0");
+  result += "'></input>&nbsp;&nbsp;&nbsp;<label>Bins:&nbsp;</label><input name='" + bgrKey + "' size='16' maxlength='40' Value='";
+  result += m_settings->Get(bgrKey, "");
 
   result += F("'></input></td></tr>");
 
@@ -146,6 +151,40 @@ void WebFrontend::Begin(StateManager *stateManager, BME280 *bme280) {
     m_webserver.send(200, "text/xml", result);
   });
 
+  // profiler capture (stopped by the download) in Chrome trace-event format
+  m_webserver.on("/trace", [this]() {
+    uint16_t pos = 0;
+    String chunk;
+
+    m_webserver.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    m_webserver.send(200, "application/json");
+    while ((chunk = Profiler::GetTraceChunk(pos)).length() > 0) {
+      m_webserver.sendContent(chunk);
+    }
+    m_webserver.client().stop();
+  });
+
+  // rollup store as CSV, e.g. /rollup?level=1m&from=3600&to=7200 (seconds of signal, see Rollup::GetTime())
+  m_webserver.on("/rollup", [this]() {
+    int8_t level = Rollup::GetLevel(m_webserver.hasArg("level") ? m_webserver.arg("level") : "1m");
+    uint32_t from = m_webserver.hasArg("from") ? m_webserver.arg("from").toInt() : 0;
+    uint32_t to = m_webserver.hasArg("to") ? m_webserver.arg("to").toInt() : UINT32_MAX;
+    String chunk;
+
+    if (!Rollup::IsEnabled() || level < 0) {
+      m_webserver.send(404, "text/plain", "rollup store disabled or unknown level (10s, 1m, 1h, 1d)");
+      return;
+    }
+
+    m_webserver.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    m_webserver.send(200, "text/csv");
+    m_webserver.sendContent("# now=" + String(Rollup::GetTime()) + "\n" + ROLLUP_HEADER + "\n");
+    while ((chunk = Rollup::GetChunk(level, from, to)).length() > 0) {
+      m_webserver.sendContent(chunk);
+    }
+    m_webserver.client().stop();
+  });
+
   m_webserver.on("/help", [this]() {
     if (IsAuthentified()) {
       String result;
@@ -163,7 +202,7 @@ void WebFrontend::Begin(StateManager *stateManager, BME280 *bme280) {
       ////uint angle = m_settings->GetUInt("SMA", 45);
       uint angle = 0;   // 0 = vertical orientation (up- or down)
       for (float i = 1; i < m_settings->BaseData.NrOfBins; i++) {
-        float freq = i * 20.0;
+        float freq = i * BIN_RESOLUTION;
         float mps = ((freq * (0.3 / 24.15)) / 2.0) / cos((PI * angle) / 180);
 
         result += "<tr>";
@@ -279,12 +318,40 @@ void WebFrontend::Begin(StateManager *stateManager, BME280 *bme280) {
             break;
           }
         }
-        if (noDigit || bgT.length() == 0 || bgTI < 1 || bgTI > 511) {
+
+        // optional bins of the group instead of the boundaries, e.g. 40-60,72, ranges ascending
+        String bgR = m_webserver.arg("BG" + String(nbr) + "R");
+        long bin = 0;
+        long rangeStart = -1;
+        for (uint16_t c = 0; c <= bgR.length(); c++) {
+          if (c < bgR.length() && isDigit(bgR[c])) {
+            bin = bin * 10 + (bgR[c] - '0');
+          } else if (c == bgR.length() || bgR[c] == ',') {
+            if (rangeStart > bin) {
+              noDigit = true;
+              break;
+            }
+            rangeStart = -1;
+            bin = 0;
+          } else if (bgR[c] == '-' && rangeStart < 0) {
+            rangeStart = bin;
+            bin = 0;
+          } else {
+            noDigit = true;
+            break;
+          }
+          if (bin > NR_OF_BINS - 1) {
+            noDigit = true;
+            break;
+          }
+        }
+
+        if (noDigit || bgT.length() == 0 || bgTI < 1 || bgTI > NR_OF_BINS - 1) {
           saveIt = false;
           String content = GetTop();
           content += F("<div align=center>");
           content += F("<br><br><h2><font color='red'>");
-          content += F("Bin numbers must be in the range 1 ... 511</font></h2>");
+          content += "Bin numbers must be in the range 1 ... " + String(NR_OF_BINS - 1) + ", bin ranges ascending (e.g. 40-60)</font></h2>";
           content += F("</div>");
           content += GetBottom();
           m_webserver.send(200, "text/html", content);
@@ -391,7 +458,102 @@ void WebFrontend::Begin(StateManager *stateManager, BME280 *bme280) {
       data += GetOption("37", value);
       data += GetOption("38", value);
       data += GetOption("39", value);
-      data += F("</select>&nbsp;&nbsp;");
+      data += F("</select>&nbsp;&nbsp;<label>Acquisition:</label>&nbsp;");
+      data += F("<select name='ADCMode' style='width:80px'>");
+      value = m_settings->Get("ADCMode", "i2s");
+      data += GetOption("i2s", value);
+      data += GetOption("timer", value);
+      data += F("</select></td></tr>");
+
+      // FFT and magnitude mode
+      data += F("<tr><td> <label>FFT mode:</label></td><td>");
+      data += F("<select name='FFTMode' style='width:80px'>");
+      value = m_settings->Get("FFTMode", "real");
+      data += GetOption("real", value);
+      data += GetOption("complex", value);
+      data += F("</select>&nbsp;&nbsp;<label>Magnitude:</label>&nbsp;");
+      data += F("<select name='MagMode' style='width:80px'>");
+      value = m_settings->Get("MagMode", "exact");
+      data += GetOption("exact", value);
+      data += GetOption("approx", value);
+      data += F("</select>&nbsp;&nbsp;<label>Window:</label>&nbsp;");
+      data += F("<select name='Window' style='width:80px'>");
+      value = m_settings->Get("Window", "symmetric");
+      data += GetOption("symmetric", value);
+      data += GetOption("periodic", value);
+      data += F("</select>&nbsp;&nbsp;<label>Processing:</label>&nbsp;");
+      data += F("<select name='ProcMode' style='width:80px'>");
+      value = m_settings->Get("ProcMode", "task");
+      data += GetOption("task", value);
+      data += GetOption("loop", value);
+      data += F("</select></td></tr>");
+
+      // Snapshot overlap
+      data += F("<tr><td> <label>Overlap (%):</label></td><td>");
+      data += F("<select name='Overlap' style='width:50px'>");
+      value = m_settings->Get("Overlap", "50");
+      data += GetOption("25", value);
+      data += GetOption("50", value);
+      data += GetOption("75", value);
+      data += F("</select>&nbsp;&nbsp;<label>Hop:</label>&nbsp;");
+      data += F("<select name='HopMode' style='width:80px'>");
+      value = m_settings->Get("HopMode", "adaptive");
+      data += GetOption("adaptive", value);
+      data += GetOption("fixed", value);
+      data += F("</select></td></tr>");
+
+      // Energy gate
+      data += F("<tr><td> <label>Gate:</label></td><td>");
+      data += F("<select name='Gate' style='width:80px'>");
+      value = m_settings->Get("Gate", "off");
+      data += GetOption("energy", value);
+      data += GetOption("off", value);
+      data += F("</select></td></tr>");
+
+      // Mains hum canceller
+      data += F("<tr><td> <label>Hum filter (Hz):</label></td><td>");
+      data += F("<select name='HumFilter' style='width:60px'>");
+      value = m_settings->Get("HumFilter", "off");
+      data += GetOption("off", value);
+      data += GetOption("50", value);
+      data += GetOption("60", value);
+      data += F("</select></td></tr>");
+
+      // Zoom FFT
+      data += F("<tr><td> <label>Zoom FFT:</label></td><td>");
+      data += F("<select name='ZoomFactor' style='width:60px'>");
+      value = m_settings->Get("ZoomFactor", "off");
+      data += GetOption("off", value);
+      data += GetOption("4", value);
+      data += GetOption("8", value);
+      data += F("</select></td></tr>");
+
+      // Rollup store (history at 10 s, 1 min, 1 h and 1 day resolution, approx. 33 kB)
+      data += F("<tr><td> <label>History:</label></td><td>");
+      data += F("<select name='Rollup' style='width:60px'>");
+      value = m_settings->Get("Rollup", "off");
+      data += GetOption("off", value);
+      data += GetOption("on", value);
+      data += F("</select></td></tr>");
+
+      // Sliding DFT
+      data += F("<tr><td> <label>Spectrum:</label></td><td>");
+      data += F("<select name='Spectrum' style='width:80px'>");
+      value = m_settings->Get("Spectrum", "fft");
+      data += GetOption("fft", value);
+      data += GetOption("both", value);
+      data += GetOption("sdft", value);
+      data += F("</select>&nbsp;&nbsp;<label>Groups:</label>&nbsp;<input name='SDFTFirstGroup' size='3' maxlength='2' Value='");
+      data += m_settings->Get("SDFTFirstGroup", String(DOM_GROUP_RAIN_FIRST));
+      data += F("'>&nbsp;-&nbsp;<input name='SDFTLastGroup' size='3' maxlength='2' Value='");
+      data += m_settings->Get("SDFTLastGroup", String(DOM_GROUP_RAIN_LAST));
+      data += F("'>&nbsp;&nbsp;<label>Hop:</label>&nbsp;");
+      data += F("<select name='SDFTHop' style='width:60px'>");
+      value = m_settings->Get("SDFTHop", "128");
+      data += GetOption("64", value);
+      data += GetOption("128", value);
+      data += GetOption("256", value);
+      data += F("</select></td></tr>");
 
       // Publish interval
       data += F("<tr><td> <label>Publish interval (s): </label></td><td><input name='PublishInterval' size='5' maxlength='4' Value='");
@@ -435,10 +597,14 @@ void WebFrontend::Begin(StateManager *stateManager, BME280 *bme280) {
       data += m_settings->GetBool("PubGCAL", false) ? "checked" : "";
       data += F(">Groups Cal&nbsp;&nbsp;&nbsp;");
 
+      data += F("<input name='PubZG' type='checkbox' value='true' ");
+      data += m_settings->GetBool("PubZG", false) ? "checked" : "";
+      data += F(">Zoom groups&nbsp;&nbsp;&nbsp;");
+
       data += F("</td></tr>");
 
       // Bin group boundaries
-      data += F("<tr><td></td><td><br>Bin group boundaries and precipitation amount factor</td></tr>");
+      data += F("<tr><td></td><td><br>Bin group boundaries, precipitation amount factor and optional bins instead of the boundaries (e.g. 40-60,72)</td></tr>");
       for (byte i = 0; i < m_settings->BaseData.NrOfBinGroups; i++) {
         data += GetBinGroupRow(i, 256);
       }
@@ -549,4 +715,4 @@ String WebFrontend::BuildHardwareRow(String text1, String text2, String text3) {
 }
 
 
-
+
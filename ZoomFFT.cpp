@@ -0,0 +1,102 @@
+#include "ZoomFFT.h"
+
+// factor: 4 or 8, 0 disables the zoom FFT
+void ZoomFFT::Begin(uint8_t factor, FFTEngine<NR_OF_FFT_SAMPLES_bit> *fft) {
+  float cutoff;
+  float tap;
+  float tapSum = 0;
+  float taps[ZOOM_FIR_TAPS];
+
+  m_fft = fft;
+  m_factor = factor;
+
+  if (m_factor) {
+    // low pass with the cutoff (-6 dB) at the new Nyquist frequency, gain 1
+    cutoff = 0.5 / m_factor;
+    for (uint8_t n = 0; n < ZOOM_FIR_TAPS; n++) {
+      float x = n - (ZOOM_FIR_TAPS - 1) / 2.0;
+      tap = 2 * cutoff * (x == 0 ? 1 : sin(2 * PI * cutoff * x) / (2 * PI * cutoff * x));
+      taps[n] = tap * (0.5 - 0.5 * cos(2 * PI * (n + 1) / (ZOOM_FIR_TAPS + 1)));
+      tapSum += taps[n];
+    }
+    for (uint8_t n = 0; n < ZOOM_FIR_TAPS; n++) {
+      m_taps[n] = round(32768 * taps[n] / tapSum);
+    }
+  }
+
+  Reset();
+}
+
+void ZoomFFT::Reset() {
+  memset(m_history, 0, sizeof(m_history));
+  m_historyPos = 0;
+  m_phase = 0;
+  m_nrOfSamples = 0;
+}
+
+bool ZoomFFT::IsEnabled() {
+  return m_factor != 0;
+}
+
+uint8_t ZoomFFT::GetFactor() {
+  return m_factor;
+}
+
+// Filters and decimates the samples into the zoom snapshot. Only every factor-th output is calculated.
+// Stops as soon as a zoom snapshot is complete and returns the number of samples taken, the caller
+// runs Calc() and passes the rest again, so no sample is lost.
+uint16_t ZoomFFT::AddSamples(const int16_t *samples, uint16_t count) {
+  const int16_t *x;
+  int32_t sum;
+  uint16_t n;
+
+  for (n = 0; n < count && m_nrOfSamples < NR_OF_FFT_SAMPLES; n++) {
+    m_history[m_historyPos] = samples[n];
+    m_history[m_historyPos + ZOOM_FIR_TAPS] = samples[n];
+    m_historyPos = (m_historyPos + 1) & (ZOOM_FIR_TAPS - 1);
+
+    if (++m_phase < m_factor) {
+      continue;
+    }
+    m_phase = 0;
+
+    // oldest sample first
+    x = &m_history[m_historyPos];
+    sum = 0;
+    for (uint8_t k = 0; k < ZOOM_FIR_TAPS; k++) {
+      sum += m_taps[k] * x[k];
+    }
+
+    m_samples[m_nrOfSamples++] = (sum + (1 << 14)) >> 15;
+  }
+
+  return n;
+}
+
+bool ZoomFFT::SnapPending() {
+  return m_nrOfSamples >= NR_OF_FFT_SAMPLES;
+}
+
+// Spectrum of the pending zoom snapshot (windowed like the main FFT, ADC offset removed), bins in
+// re[0 ... NR_OF_FFT_SAMPLES/2 - 1] and im[0 ... NR_OF_FFT_SAMPLES/2 - 1]. Keeps the second half of
+// the snapshot as the beginning of the next one.
+void ZoomFFT::Calc(int16_t *re, int16_t *im) {
+  const int16_t *window = m_fft->WindowTable();
+  int32_t sampleSUM = 0;
+  int16_t offset;
+
+  for (uint16_t n = 0; n < NR_OF_FFT_SAMPLES; n++) {
+    sampleSUM += m_samples[n];
+  }
+  offset = sampleSUM >> NR_OF_FFT_SAMPLES_bit;
+
+  // packed input of RealFFTPacked(): even samples in re, odd samples in im
+  for (uint16_t n = 0; n < NR_OF_FFT_SAMPLES; n += 2) {
+    re[n >> 1] = FFTEngine<NR_OF_FFT_SAMPLES_bit>::MAS((m_samples[n] - offset) << 4, window[n]);
+    im[n >> 1] = FFTEngine<NR_OF_FFT_SAMPLES_bit>::MAS((m_samples[n + 1] - offset) << 4, window[n + 1]);
+  }
+  m_fft->RealFFTPacked(re, im);
+
+  memmove(m_samples, m_samples + (NR_OF_FFT_SAMPLES >> 1), (NR_OF_FFT_SAMPLES >> 1) * sizeof(int16_t));
+  m_nrOfSamples -= NR_OF_FFT_SAMPLES >> 1;
+}
@@ -0,0 +1,36 @@
+#ifndef __ZOOMFFT__h
+#define __ZOOMFFT__h
+
+#include "Arduino.h"
+#include "GlobalDefines.h"
+#include "FFTEngine.h"
+
+#define ZOOM_FIR_TAPS              128        // windowed sinc, transition width approx. 500 Hz
+
+// Zoom FFT for the low frequency band: the decimated samples are low pass filtered and decimated
+// once more by the zoom factor (4 or 8), then the same NR_OF_FFT_SAMPLES point FFT results in a
+// 4 or 8 times finer bin resolution from 0 Hz to NR_OF_ZOOM_BINS * BIN_RESOLUTION / factor.
+// The band starts at 0 Hz, so no mixer is needed in front of the filter.
+// Zoom snapshots overlap by 50 %, i.e. one every NR_OF_FFT_SAMPLES / 2 * factor samples.
+class ZoomFFT {
+public:
+  void Begin(uint8_t factor, FFTEngine<NR_OF_FFT_SAMPLES_bit> *fft);
+  void Reset();
+  bool IsEnabled();
+  uint8_t GetFactor();
+  uint16_t AddSamples(const int16_t *samples, uint16_t count);
+  bool SnapPending();
+  void Calc(int16_t *re, int16_t *im);
+
+private:
+  FFTEngine<NR_OF_FFT_SAMPLES_bit> *m_fft;
+  uint8_t m_factor;
+  int16_t m_taps[ZOOM_FIR_TAPS];                     // Q15
+  int16_t m_history[ZOOM_FIR_TAPS << 1];             // every sample twice, so the taps never wrap
+  uint8_t m_historyPos;
+  uint8_t m_phase;
+  int16_t m_samples[NR_OF_FFT_SAMPLES];              // zoom samples, oldest first
+  uint16_t m_nrOfSamples;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#!/usr/bin/env python3
+# Synthetic rain recording for the host build: raw ADC values (uint16_t little endian) at SAMPLE_RATE,
+# gaussian noise plus decaying doppler bursts of random frequency and amplitude (drops). With a tone
+# frequency the drops are replaced by a steady tone (amplitude 300), a constant rain rate.
+#   SyntheticRain.py <file> [seconds] [seed] [tone Hz]
+import array
+import math
+import random
+import sys
+
+SAMPLE_RATE = 40960
+
+path = sys.argv[1]
+seconds = int(sys.argv[2]) if len(sys.argv) > 2 else 10
+random.seed(int(sys.argv[3]) if len(sys.argv) > 3 else 1)
+tone = float(sys.argv[4]) if len(sys.argv) > 4 else 0
+
+n = SAMPLE_RATE * seconds
+x = [random.gauss(0, 40 if tone == 0 else 1) for _ in range(n)]
+for t in range(n if tone > 0 else 0):
+    x[t] += 300 * math.sin(2 * math.pi * tone * t / SAMPLE_RATE)
+for drop in range(60 * seconds if tone == 0 else 0):
+    start = random.randrange(0, n - 4000)
+    w = 2 * math.pi * random.uniform(300, 3000) / SAMPLE_RATE
+    amplitude = random.uniform(50, 800)
+    tau = random.uniform(200, 1500)
+    for t in range(4000):
+        x[start + t] += amplitude * math.exp(-t / tau) * math.sin(w * t)
+
+with open(path, 'wb') as f:
+    f.write(array.array('H', [min(4095, max(0, round(2048 + v))) for v in x]).tobytes())
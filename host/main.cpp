@@ -0,0 +1,204 @@
+// Host driver of the signal chain: runs the replay, benchmark and accuracy commands of the firmware
+// and processes recorded raw ADC files (uint16_t little endian at SAMPLE_RATE) through the
+// unmodified acquisition and processing path.
+//
+// Usage: replayHost [set:<key>=<value> ...] <command> ...
+//   set:<key>=<value>    setting as stored by the web frontend, applied before all commands
+//   <replay params>      replay command, e.g. "tone" or "chirp,10,20,8000,500"
+//   bench=<params>       benchmark command, e.g. "bench=stat,20"
+//   acc=<params>         accuracy test command, e.g. "acc=all"
+//   file=<path>          processes a recording, the interval ends with the end of the file
+//   dump                 group and sample bin averages of the last interval
+//   quant                group maximum and quantiles of the last interval
+//   current              groups of the running interval (GetCurrent)
+//   rollup=<level>       rollup records of a level, needs set:Rollup=on
+//   check=rollup         the 1 min records of the last file add up to the amount of its completed
+//                        intervals, needs set:Rollup=on and a PublishInterval dividing 60 s
+#include <unistd.h>
+#include "Arduino.h"
+#include "GlobalDefines.h"
+#include "Settings.h"
+#include "SensorData.h"
+#include "Statistics.h"
+#include "SigProc.h"
+#include "Publisher.h"
+#include "Replay.h"
+#include "Watchdog.h"
+#include "DataPort.h"
+#include "BME280.h"
+#include "Benchmark.h"
+#include "AccuracyTest.h"
+#include "Rollup.h"
+#include "StreamSampleSource.h"
+#include "Tools.h"
+
+#define HOST_MAG_THRESH            5          // calibration of all groups, there is no NVS calibration on the host
+
+Settings settings;
+SensorData sensorData(NR_OF_BINS, NR_OF_BIN_GROUPS);
+Statistics statistics;
+SigProc sigProc;
+Publisher publisher;
+Replay replay;
+Watchdog watchdog;
+DataPort dataPort;
+BME280 bme280;
+Benchmark benchmark;
+AccuracyTest accuracyTest;
+float intervalAmount;           // preciAmountAcc of the intervals completed within the last file
+
+static void Setup() {
+  settings.BaseData.NrOfBins = NR_OF_BINS;
+  settings.BaseData.NrOfBinGroups = NR_OF_BIN_GROUPS;
+  for (byte nbr = 0; nbr < NR_OF_BIN_GROUPS; nbr++) {
+    sensorData.binGroup[nbr].lastBin = settings.GetUInt("BG" + String(nbr) + "T", defaultBinGroupBoundary[nbr]);
+    sensorData.binGroup[nbr].firstBin = (nbr == 0) ? 1 : sensorData.binGroup[nbr - 1].lastBin + 1;
+    sensorData.binGroup[nbr].preciAmountFactor = settings.GetUInt("BG" + String(nbr) + "F", defaultPreciAmountFactor[nbr]);
+    sensorData.binGroup[nbr].magThresh = HOST_MAG_THRESH;
+  }
+
+  publisher.Begin(&settings, &dataPort, &bme280);
+  statistics.Begin(&settings, &sensorData);
+  sigProc.Begin(&settings, &sensorData, &statistics, &publisher);
+  if (settings.Get("Rollup", "off") == "on") {
+    Rollup::Begin();
+  }
+  replay.Begin(&sigProc, &statistics, &sensorData, &watchdog);
+  benchmark.Begin(&sigProc, &watchdog);
+  accuracyTest.Begin(&sigProc, &watchdog);
+}
+
+static void ProcessFile(const char *path) {
+  FileStream stream(path);
+  StreamSampleSource source(&stream);
+
+  if (!stream.f) {
+    printf("file=%s not found\n", path);
+    return;
+  }
+
+  sigProc.Lock();
+  statistics.Reset();
+  sigProc.ResetCapture();
+  sigProc.SetSampleSource(&source);
+  sigProc.StartCapture();
+  sigProc.Unlock();
+
+  // pipelined: the processing task reads the file, loop mode: Handle() does
+  do {
+    sigProc.Handle();
+    usleep(100);
+    sigProc.Lock();
+    bool finished = source.IsFinished() && !sigProc.SnapPending();
+    sigProc.Unlock();
+    if (finished) {
+      break;
+    }
+  } while (true);
+
+  // the stream is gone after the return
+  sigProc.Lock();
+  sigProc.StopCapture();
+  intervalAmount = sensorData.preciAmountAcc;
+  statistics.Finalize();
+  printf("file=%s samples=%u validSnapshots=%u weight=%.2f magMax=%u domGroup=%d/%d preciAmount=%.6g\n", path, source.GetSampleCount(),
+    sensorData.snapshotValidCtr, sensorData.snapshotValidWeight, sensorData.magMax, sensorData.DomGroupMagAVGkorr, sensorData.DomGroupMagAboveThreshCnt, sensorData.preciAmount);
+  sigProc.Unlock();
+}
+
+static void Dump() {
+  for (uint8_t g = 0; g < NR_OF_BIN_GROUPS; g++) {
+    printf("G%d %.6g %.6g %.6g %.6g\n", g, sensorData.binGroup[g].magAVG, sensorData.binGroup[g].magAVGkorr, sensorData.binGroup[g].magAboveThreshCnt, sensorData.binGroup[g].magAVGkorrGated);
+  }
+  for (uint16_t b = 0; b < NR_OF_BINS; b += 37) {
+    printf("B%d %.6g %.6g\n", b, sensorData.bin.magAVG[b], sensorData.bin.magAVGkorr[b]);
+  }
+  printf("P %.6g %.6g %.6g %d %d\n", sensorData.magAVG, sensorData.magAVGkorr, sensorData.preciAmount, sensorData.DomGroupMagAVGkorr, sensorData.DomGroupMagAboveThreshCnt);
+}
+
+static void Quantiles() {
+  for (uint8_t g = 0; g < NR_OF_BIN_GROUPS; g++) {
+    printf("Q%d max=%u q50=%u q95=%u q99=%u\n", g, sensorData.binGroup[g].magMax, sensorData.binGroup[g].magQ50, sensorData.binGroup[g].magQ95, sensorData.binGroup[g].magQ99);
+  }
+}
+
+static void Current() {
+  SensorData current(0, NR_OF_BIN_GROUPS);
+
+  sigProc.Lock();
+  statistics.GetCurrent(&current);
+  sigProc.Unlock();
+  printf("current weight=%.2f magMax=%u magAVGkorr=%.6g domGroup=%d/%d preciAmount=%.6g\n", current.snapshotValidWeight, current.magMax, current.magAVGkorr,
+    current.DomGroupMagAVGkorr, current.DomGroupMagAboveThreshCnt, current.preciAmount);
+}
+
+static void PrintRollup(const char *level) {
+  uint32_t from = 0;
+  String chunk;
+
+  printf("now=%u\n%s\n", Rollup::GetTime(), ROLLUP_HEADER);
+  while ((chunk = Rollup::GetChunk(Rollup::GetLevel(level), from, UINT32_MAX)).length() > 0) {
+    fputs(chunk.c_str(), stdout);
+  }
+}
+
+// sum of the preciAmount column of the 1 min records against the completed intervals, 1 % tolerance
+static void CheckRollup() {
+  uint32_t from = 0;
+  String chunk;
+  String line;
+  float amount = 0;
+  int start;
+  int end;
+
+  while ((chunk = Rollup::GetChunk(Rollup::GetLevel("1m"), from, UINT32_MAX)).length() > 0) {
+    for (start = 0; (end = chunk.indexOf('\n', start)) >= 0; start = end + 1) {
+      line = chunk.substring(start, end);
+      amount += Tools::GetParam(line, 2, "0").toFloat();
+    }
+  }
+  printf("check=rollup,records=%.6g,preciAmountAcc=%.6g,result=%s\n", amount, intervalAmount,
+    fabsf(amount - intervalAmount) <= 0.01f * fabsf(intervalAmount) + 1e-9f ? "pass" : "fail");
+}
+
+int main(int argc, char **argv) {
+  String setting;
+  int split;
+
+  // deterministic by default, "set:ProcMode=task" for the pipelined mode
+  settings.Add("ProcMode", "loop");
+  for (int i = 1; i < argc; i++) {
+    if (!strncmp(argv[i], "set:", 4)) {
+      setting = argv[i] + 4;
+      split = setting.indexOf('=');
+      settings.Add(setting.substring(0, split), setting.substring(split + 1));
+    }
+  }
+  Setup();
+
+  for (int i = 1; i < argc; i++) {
+    if (!strncmp(argv[i], "set:", 4)) {
+      continue;
+    } else if (!strncmp(argv[i], "file=", 5)) {
+      ProcessFile(argv[i] + 5);
+    } else if (!strncmp(argv[i], "bench=", 6)) {
+      printf("%s\n", benchmark.Run(argv[i] + 6).c_str());
+    } else if (!strncmp(argv[i], "acc=", 4)) {
+      printf("%s\n", accuracyTest.Run(argv[i] + 4).c_str());
+    } else if (!strcmp(argv[i], "dump")) {
+      Dump();
+    } else if (!strcmp(argv[i], "quant")) {
+      Quantiles();
+    } else if (!strcmp(argv[i], "current")) {
+      Current();
+    } else if (!strcmp(argv[i], "check=rollup")) {
+      CheckRollup();
+    } else if (!strncmp(argv[i], "rollup=", 7)) {
+      PrintRollup(argv[i] + 7);
+    } else {
+      printf("%s\n", replay.Run(argv[i]).c_str());
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,133 @@
+// Minimal Arduino / ESP32 core for the host build of the signal chain (see host/CMakeLists.txt).
+// Only what the firmware sources of the host target use, single core, no hardware.
+#pragma once
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+using std::min;
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+using std::max;
+typedef uint8_t byte; typedef unsigned int uint; typedef uint16_t word;
+#define IRAM_ATTR
+#define PROGMEM
+#define PI 3.1415926535897932384626433832795
+#define HEX 16
+#define DEC 10
+#define HIGH 1
+#define LOW 0
+#define OUTPUT 1
+#define F(x) x
+#define FPSTR(x) x
+class String {
+public:
+  std::string s;
+  String() {}
+  String(const char *c) : s(c ? c : "") {}
+  String(const std::string &c) : s(c) {}
+  String(char c) : s(1, c) {}
+  String(int v, int base = 10) { char b[40]; if (base == 16) snprintf(b, 40, "%x", v); else snprintf(b, 40, "%d", v); s = b; }
+  String(unsigned int v, int base = 10) { char b[40]; if (base == 16) snprintf(b, 40, "%x", v); else snprintf(b, 40, "%u", v); s = b; }
+  String(long v, int base = 10) : String((int)v, base) {}
+  String(unsigned long v, int base = 10) : String((unsigned)v, base) {}
+  String(unsigned char v, int base = 10) : String((unsigned)v, base) {}
+  String(float v, int d = 2) { char b[64]; snprintf(b, 64, "%.*f", d, v); s = b; }
+  String(double v, int d = 2) { char b[64]; snprintf(b, 64, "%.*f", d, v); s = b; }
+  unsigned length() const { return s.size(); }
+  const char *c_str() const { return s.c_str(); }
+  String &operator+=(const String &o) { s += o.s; return *this; }
+  String &operator+=(const char *o) { s += o; return *this; }
+  String &operator+=(char o) { s += o; return *this; }
+  friend String operator+(const String &a, const String &b) { return String(a.s + b.s); }
+  friend String operator+(const char *a, const String &b) { return String(std::string(a) + b.s); }
+  friend String operator+(const String &a, const char *b) { return String(a.s + b); }
+  bool operator==(const String &o) const { return s == o.s; }
+  bool operator==(const char *o) const { return s == o; }
+  bool operator!=(const String &o) const { return s != o.s; }
+  bool operator!=(const char *o) const { return s != o; }
+  char operator[](unsigned i) const { return i < s.size() ? s[i] : 0; }
+  char charAt(unsigned i) const { return (*this)[i]; }
+  bool startsWith(const String &p) const { return s.compare(0, p.s.size(), p.s) == 0; }
+  bool endsWith(const String &p) const { return s.size() >= p.s.size() && s.compare(s.size() - p.s.size(), p.s.size(), p.s) == 0; }
+  int indexOf(const String &p, unsigned from = 0) const { size_t r = s.find(p.s, from); return r == std::string::npos ? -1 : (int)r; }
+  int indexOf(char c, unsigned from = 0) const { size_t r = s.find(c, from); return r == std::string::npos ? -1 : (int)r; }
+  String substring(unsigned from) const { return from >= s.size() ? String() : String(s.substr(from)); }
+  String substring(unsigned from, unsigned to) const { if (from >= s.size()) return String(); return String(s.substr(from, to - from)); }
+  long toInt() const { return atol(s.c_str()); }
+  float toFloat() const { return atof(s.c_str()); }
+  void trim() { size_t a = s.find_first_not_of(" \t\r\n"); size_t b = s.find_last_not_of(" \t\r\n"); s = a == std::string::npos ? "" : s.substr(a, b - a + 1); }
+  void toUpperCase() { for (auto &c : s) c = toupper(c); }
+  void replace(const String &a, const String &b) { size_t p = 0; while (!a.s.empty() && (p = s.find(a.s, p)) != std::string::npos) { s.replace(p, a.s.size(), b.s); p += b.s.size(); } }
+  bool equals(const String &o) const { return s == o.s; }
+  void reserve(unsigned n) { s.reserve(n); }
+};
+struct SerialStub {
+  void begin(int) {}
+  template<typename T> void print(T) {}
+  template<typename T> void println(T) {}
+  void println() {}
+  int printf(const char *, ...) { return 0; }
+};
+extern SerialStub Serial;
+struct ESPStub {
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 80; }
+  uint32_t getFreeHeap() { return 100000; }
+  void restart() {}
+  const char *getSdkVersion() { return "host"; }
+};
+extern ESPStub ESP;
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long);
+void yield();
+inline void digitalWrite(int, int) {}
+inline void pinMode(int, int) {}
+uint16_t analogRead(int);
+inline void analogSetAttenuation(int) {}
+inline void analogSetWidth(int) {}
+inline void analogSetCycles(int) {}
+inline void analogSetSamples(int) {}
+inline void analogSetClockDiv(int) {}
+inline void adcAttachPin(int) {}
+#define ADC_6db 2
+typedef struct hw_timer_s hw_timer_t;
+hw_timer_t *timerBegin(int, int, bool);
+inline void timerAlarmWrite(hw_timer_t *, int, bool) {}
+inline void timerAttachInterrupt(hw_timer_t *, void (*)(), bool) {}
+inline void timerAlarmEnable(hw_timer_t *) {}
+inline void timerAlarmDisable(hw_timer_t *) {}
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline int8_t digitalPinToAnalogChannel(uint8_t pin) { return pin >= 32 && pin <= 39 ? (pin >= 36 ? pin - 36 : pin - 28) : -1; }
+class Stream {
+public:
+  virtual ~Stream() {}
+  virtual size_t readBytes(uint8_t *buffer, size_t length) = 0;
+};
+class FileStream : public Stream {
+public:
+  FILE *f;
+  FileStream(const char *path) { f = fopen(path, "rb"); }
+  size_t readBytes(uint8_t *buffer, size_t length) { return f ? fread(buffer, 1, length, f) : 0; }
+};
+// FreeRTOS shim (host threads)
+typedef void *TaskHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef int BaseType_t;
+typedef void *QueueHandle_t;
+#define pdPASS 1
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffff
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *, uint32_t, void *, int, TaskHandle_t *, int);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex();
+int xSemaphoreTakeRecursive(SemaphoreHandle_t, uint32_t);
+int xSemaphoreGiveRecursive(SemaphoreHandle_t);
+void vTaskDelay(uint32_t);
+inline BaseType_t xQueueReceive(QueueHandle_t, void *, uint32_t) { return pdFALSE; }
+inline uint32_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+inline int xPortGetCoreID() { return 0; }
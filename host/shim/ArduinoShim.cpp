@@ -0,0 +1,80 @@
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "Arduino.h"
+#include "Wire.h"
+#include "WiFi.h"
+#include "soc/efuse_reg.h"
+
+SerialStub Serial;
+ESPStub ESP;
+WiFiStub WiFi;
+TwoWire Wire;
+
+// SAR ADC1 register of the register-level ADC read, the conversion is always done
+volatile uint32_t g_sensReg = 1u << 16;
+
+static std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+static uint64_t ElapsedNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// 80 MHz cycle counter, like the ESP32 at the lowest CPU frequency
+uint32_t ESPStub::getCycleCount() {
+  return (uint32_t)(ElapsedNs() * 2 / 25);
+}
+
+unsigned long millis() {
+  return ElapsedNs() / 1000000;
+}
+
+unsigned long micros() {
+  return ElapsedNs() / 1000;
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {
+}
+
+uint16_t analogRead(int) {
+  return 2048;
+}
+
+hw_timer_t *timerBegin(int, int, bool) {
+  return nullptr;
+}
+
+void esp_efuse_mac_get_default(uint8_t *mac) {
+  memset(mac, 0, 6);
+}
+
+// FreeRTOS on host threads, the core is ignored
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *, uint32_t, void *param, int, TaskHandle_t *handle, int) {
+  std::thread(fn, param).detach();
+  if (handle) {
+    *handle = (void *)1;
+  }
+  return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+  return new std::recursive_mutex();
+}
+
+int xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, uint32_t) {
+  ((std::recursive_mutex *)mutex)->lock();
+  return 1;
+}
+
+int xSemaphoreGiveRecursive(SemaphoreHandle_t mutex) {
+  ((std::recursive_mutex *)mutex)->unlock();
+  return 1;
+}
+
+void vTaskDelay(uint32_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
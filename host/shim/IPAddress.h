@@ -0,0 +1,3 @@
+#pragma once
+#include "Arduino.h"
+class IPAddress { public: IPAddress() {} IPAddress(int,int,int,int) {} IPAddress(uint32_t) {} String toString() const { return "0.0.0.0"; } bool fromString(const String &) { return true; } operator uint32_t() const { return 0; } };
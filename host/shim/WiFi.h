@@ -0,0 +1,10 @@
+#pragma once
+#include "Arduino.h"
+#include "IPAddress.h"
+#define WL_CONNECTED 3
+class WiFiClient { public: bool connect(const char*, int) { return false; } void setNoDelay(bool) {} void print(const String&) {} void println(const String&) {} void stop() {} bool connected() { return false; } int available() { return 0; } int readBytes(char*, int) { return 0; } };
+class WiFiServer { public: WiFiServer(int) {} void begin() {} void setNoDelay(bool) {} bool hasClient() { return false; } WiFiClient available() { return WiFiClient(); } };
+enum WiFiMode_t { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA };
+struct WiFiStub { int status() { return 0; } String SSID() { return ""; } String macAddress() { return ""; } int RSSI() { return 0; } WiFiMode_t getMode() { return WIFI_OFF; } };
+extern WiFiStub WiFi;
+
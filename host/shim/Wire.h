@@ -0,0 +1,4 @@
+#pragma once
+#include "Arduino.h"
+struct TwoWire { void begin() {} void setClock(int) {} void beginTransmission(int) {} int endTransmission(bool = true) { return 1; } void write(uint8_t) {} int requestFrom(int, int) { return 0; } int read() { return 0; } int available() { return 0; } };
+extern TwoWire Wire;
@@ -0,0 +1,6 @@
+#pragma once
+#include "driver/i2s.h"
+typedef enum { ADC_WIDTH_BIT_12 = 3 } adc_bits_width_t;
+typedef enum { ADC_ATTEN_DB_6 = 2 } adc_atten_t;
+inline esp_err_t adc1_config_width(adc_bits_width_t) { return 0; }
+inline esp_err_t adc1_config_channel_atten(adc1_channel_t, adc_atten_t) { return 0; }
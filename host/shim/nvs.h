@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+typedef uint32_t nvs_handle; typedef int esp_err_t;
+#define ESP_OK 0
+enum nvs_open_mode { NVS_READONLY, NVS_READWRITE };
+inline esp_err_t nvs_open(const char*, nvs_open_mode, nvs_handle*) { return 1; }
+inline esp_err_t nvs_get_str(nvs_handle, const char*, char*, size_t*) { return 1; }
+inline esp_err_t nvs_set_str(nvs_handle, const char*, const char*) { return 1; }
+inline esp_err_t nvs_get_blob(nvs_handle, const char*, void*, size_t*) { return 1; }
+inline esp_err_t nvs_set_blob(nvs_handle, const char*, const void*, size_t) { return 1; }
+inline esp_err_t nvs_commit(nvs_handle) { return 0; }
+inline void nvs_close(nvs_handle) {}
+inline esp_err_t nvs_flash_init() { return 0; }
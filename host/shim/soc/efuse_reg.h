@@ -0,0 +1,7 @@
+#pragma once
+#include <cstdint>
+void esp_efuse_mac_get_default(uint8_t*);
+#define REG_READ(x) 0
+#define EFUSE_BLK0_RDATA3_REG 0
+#define EFUSE_RD_CHIP_VER_RESERVE_S 0
+#define EFUSE_RD_CHIP_VER_RESERVE_V 0
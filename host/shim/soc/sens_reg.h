@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+extern volatile uint32_t g_sensReg;
+#define SENS_SAR_MEAS_START1_REG (&g_sensReg)
+#define SENS_SAR1_EN_PAD 0xFFF
+#define SENS_SAR1_EN_PAD_S 19
+#define SENS_MEAS1_START_SAR (1u<<17)
+#define SENS_MEAS1_DONE_SAR (1u<<16)
+#define SENS_MEAS1_DATA_SAR 0xFFFF
+#define SENS_MEAS1_DATA_SAR_S 0
+#define SET_PERI_REG_BITS(r, m, v, s) (*(r) = (*(r) & ~((m) << (s))) | (((v) & (m)) << (s)))
+#define CLEAR_PERI_REG_MASK(r, m) (*(r) &= ~(m))
+#define SET_PERI_REG_MASK(r, m) (*(r) |= (m))
+#define GET_PERI_REG_MASK(r, m) (*(r) & (m))
+#define GET_PERI_REG_BITS2(r, m, s) ((*(r) >> (s)) & (m))
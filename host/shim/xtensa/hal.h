@@ -0,0 +1,4 @@
+#pragma once
+#include <stdint.h>
+#include <time.h>
+inline uint32_t xthal_get_ccount() { timespec t; clock_gettime(CLOCK_MONOTONIC, &t); return (uint32_t)(t.tv_sec * 80000000ull + t.tv_nsec / 12.5); }
@@ -68,6 +68,11 @@
 #include "DataPort.h"
 #include "Statistics.h"
 #include "SigProc.h"
+#include "Replay.h"
+#include "Benchmark.h"
+#include "AccuracyTest.h"
+#include "Profiler.h"
+#include "Rollup.h"
 #include "ConnectionKeeper.h"
 #include "Wire.h"
 #include "BME280.h"
@@ -80,9 +85,13 @@ Watchdog watchdog;
 OTAUpdate ota;
 Publisher publisher;
 SensorData sensorData(NR_OF_BINS, NR_OF_BIN_GROUPS);
+SensorData currentData(0, NR_OF_BIN_GROUPS);    // groups of the current interval ("current" command)
 DataPort dataPort;
 Statistics statistics;
 SigProc sigProc;
+Replay replay;
+Benchmark benchmark;
+AccuracyTest accuracyTest;
 ConnectionKeeper connectionKeeper;
 BME280 bme280;
 
@@ -271,11 +280,22 @@ void setup() {
   // Initialize the publisher
   publisher.Begin(&settings, &dataPort, &bme280);
 
+  // Initialize statistics, before the signal processing: it applies the bin lists (BG<n>R) to the
+  // group spans the sliding DFT is sized by
+  statistics.Begin(&settings, &sensorData);
+  if (settings.Get("Rollup", "off") == "on") {
+    Rollup::Begin();
+  }
+
   // Initialize signal processing
   sigProc.Begin(&settings, &sensorData, &statistics, &publisher);
+  Serial.println("ADC acquisition: " + sigProc.GetSampleSourceName());
+  Serial.println(sigProc.IsPipelined() ? "Processing: task on core " + String(SIGPROC_TASK_CORE) : "Processing: loop");
 
-  // Initialize statistics
-  statistics.Begin(&settings, &sensorData);
+  // Initialize the replay driver (signal chain test without sensor)
+  replay.Begin(&sigProc, &statistics, &sensorData, &watchdog);
+  benchmark.Begin(&sigProc, &watchdog);
+  accuracyTest.Begin(&sigProc, &watchdog);
   
   // Go
   sigProc.StartCapture();
@@ -312,17 +332,128 @@ String CommandHandler(String command) {
     settings.Write();
   }
   else if (command.startsWith("calibrate")) {
-    statistics.Calibrate();
+    // calibrate[=max|q50|q95|q99]: thresholds from the maximum or a quantile of the last interval
+    sigProc.Lock();
+    statistics.Calibrate(Statistics::CalibrationSourceFromString(command.substring(10)));
     settings.SaveCalibration(&sensorData);
+    sigProc.Unlock();
   }
   else if (command.startsWith("resetPreciAmount")) {
+    sigProc.Lock();
     statistics.ResetPreciAmountAcc();
+    sigProc.Unlock();
+  }
+  else if (command.startsWith("current")) {
+    // values of the interval so far, e.g. for an alarm before the next publish
+    sigProc.Lock();
+    statistics.GetCurrent(&currentData);
+    sigProc.Unlock();
+    result = GetCurrentStatistics();
+  }
+  else if (command.startsWith("rollup")) {
+    // rollup=<10s|1m|1h|1d>[,from[,to]], up to ROLLUP_DATAPORT_RECORDS records of the level in one line, the next
+    // page starts at next. records: separated by ';', the fields of ROLLUP_HEADER separated by ' '
+    String params = command.substring(7);
+    int8_t level = Rollup::GetLevel(Tools::GetParam(params, 0, "1m"));
+    uint32_t from = Tools::GetParam(params, 1, "0").toInt();
+    String toParam = Tools::GetParam(params, 2, "");
+    uint32_t to = toParam.length() > 0 ? toParam.toInt() : UINT32_MAX;
+
+    if (!Rollup::IsEnabled() || level < 0) {
+      result = "rollup=disabled or unknown level";
+    }
+    else {
+      String fields = ROLLUP_HEADER;
+      String records = Rollup::GetChunk(level, from, to, ROLLUP_DATAPORT_RECORDS);
+      records.trim();
+      fields.replace(",", " ");
+      records.replace(",", " ");
+      records.replace("\n", ";");
+      result = "rollup=level=" + Tools::GetParam(params, 0, "1m") +
+               ",now=" + String(Rollup::GetTime()) +
+               ",next=" + String(from) +
+               ",fields=" + fields +
+               ",records=" + records;
+    }
+  }
+  else if (command.startsWith("replay")) {
+    // e.g. replay=tone,5,1000,0,1000
+    result = replay.Run(command.substring(7));
+  }
+  else if (command.startsWith("benchmark")) {
+    // e.g. benchmark=fft,100
+    result = benchmark.Run(command.substring(10));
+  }
+  else if (command.startsWith("accuracy")) {
+    // e.g. accuracy=all or accuracy=rain,bins
+    result = accuracyTest.Run(command.substring(9));
+  }
+  else if (command.startsWith("profile")) {
+    // profile=start[,spans], profile=stop, profile: status; the capture is read from http://<ip>/trace
+    String action = Tools::GetParam(command.substring(8), 0, "");
+    if (action == "start") {
+      Profiler::Start(Tools::GetParam(command.substring(8), 1, String(PROFILER_DEFAULT_CAPACITY)).toInt());
+    }
+    else if (action == "stop") {
+      Profiler::Stop();
+    }
+    result = "profile=" + Profiler::GetStatus();
   }
 
   return result;
 }
 
+String GetCurrentStatistics() {
+  String groupMagAVGkorr;
+  String groupMagAboveThreshCnt;
+
+  for (byte i = 0; i < NR_OF_BIN_GROUPS; i++) {
+    groupMagAVGkorr += String(currentData.binGroup[i].magAVGkorr, 4) + " ";
+    groupMagAboveThreshCnt += String(currentData.binGroup[i].magAboveThreshCnt, 4) + " ";
+  }
+  groupMagAVGkorr.trim();
+  groupMagAboveThreshCnt.trim();
+
+  return "current=weight=" + String(currentData.snapshotValidWeight, 2) +
+         ",magMax=" + String(currentData.magMax) +
+         ",magAVGkorr=" + String(currentData.magAVGkorr, 4) +
+         ",domGroupMagAVGkorr=" + String(currentData.DomGroupMagAVGkorr) +
+         ",domGroupMagAboveThreshCnt=" + String(currentData.DomGroupMagAboveThreshCnt) +
+         ",preciAmount=" + String(currentData.preciAmount, 4) +
+         ",groupMagAVGkorr=" + groupMagAVGkorr +
+         ",groupMagAboveThreshCnt=" + groupMagAboveThreshCnt;
+}
+
+// Load of the signal processing task, once per second
+void UpdateTaskState() {
+  static unsigned long lastUpdate = 0;
+
+  if (millis() - lastUpdate < 1000) {
+    return;
+  }
+  lastUpdate = millis();
+
+  if (sigProc.IsPipelined()) {
+    stateManager.SetValue("CPU SigProc task (%)", String(sigProc.GetTaskLoad(), 1));
+    stateManager.SetValue("SigProc stack free", String(sigProc.GetTaskStackFree()));
+    stateManager.SetValue("Publish drops", String(sigProc.GetPublishDropCount()));
+  }
+
+  IsrStatistics isrStats;
+  if (sigProc.TakeIsrStatistics(&isrStats) && isrStats.count > 0) {
+    String histogram;
+    for (uint8_t i = 0; i < ISR_HISTOGRAM_BUCKETS; i++) {
+      histogram += (i > 0 ? "/" : "") + String(isrStats.histogram[i]);
+    }
+    stateManager.SetValue("ISR cycles min/avg/max", String(isrStats.minCycles) + "/" + String(isrStats.avgCycles) + "/" + String(isrStats.maxCycles));
+    stateManager.SetValue("ISR histogram (<64 .. >=4096)", histogram);
+    stateManager.SetValue("CPU sampling ISR w/o dispatch (%)", String(100.0 * isrStats.avgCycles * SAMPLE_RATE / (ESP.getCpuFreqMHz() * 1000000.0), 1));
+  }
+}
+
 void loop() {
+  uint32_t startCycles;
+
   stateManager.SetLoopStart();
   
   watchdog.Handle();
@@ -330,7 +461,9 @@ void loop() {
   if (connectionKeeper.IsConnected()) {
     ota.Handle();
     if (dataPort.IsEnabled()) {
+      startCycles = Profiler::Now();
       dataPort.Handle(CommandHandler);
+      Profiler::Record(PROFILE_DATAPORT, startCycles, PROFILER_POLL_MIN_CYCLES);
     }
   }
 
@@ -342,7 +475,11 @@ void loop() {
     connectionKeeper.Handle();
   }
 
+  startCycles = Profiler::Now();
   frontend.Handle();
+  Profiler::Record(PROFILE_FRONTEND, startCycles, PROFILER_POLL_MIN_CYCLES);
+
+  UpdateTaskState();
 
   stateManager.SetLoopEnd();
-} 
+} 